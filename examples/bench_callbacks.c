@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Compares the cost of notifying 1, 10 and 100 display state handlers
+ * connected as GSignal handlers (mce_display_add_state_changed_handler)
+ * with the same number of plain callbacks
+ * (mce_display_add_state_changed_callback).
+ *
+ * A burst of display state changes is first recorded from the (fake)
+ * mce peer, then replayed through MceDisplay for each configuration,
+ * so that D-Bus doesn't get in the way. The "none" line is the cost
+ * of the update itself, with nothing connected to the state signal.
+ *
+ * Usage: bench_callbacks [count]
+ */
+
+#include "bench_common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <mce_display.h>
+#include <mce_proxy.h>
+#include <mce_recorder.h>
+
+#define BENCH_MAX_HANDLERS 100
+
+/* ========================================================================= *
+ * RECORDING
+ * ========================================================================= */
+
+static void count_cb(MceDisplay *display, void *arg)
+{
+    unsigned *count = arg;
+
+    (void)display;
+    ++*count;
+}
+
+static void record(const char *path, unsigned n)
+{
+    bench_peer_t *peer    = bench_peer_create();
+    MceProxy     *proxy   = mce_proxy_new_for_connection(
+                                bench_peer_client(peer), NULL, NULL, NULL);
+    MceDisplay   *display = mce_display_new_for_proxy(proxy);
+    GError       *error   = NULL;
+    unsigned      count   = 0;
+
+    MceRecorder *recorder = mce_recorder_new(proxy, path, &error);
+    if( !recorder ) {
+        fprintf(stderr, "%s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+
+    gulong id = mce_display_add_state_changed_handler(display, count_cb,
+                                                      &count);
+    while( !display->valid )
+        g_main_context_iteration(NULL, true);
+
+    /* Every signal flips the state */
+    bool on = (display->state != MCE_DISPLAY_STATE_ON);
+    for( unsigned i = 0; i < n; ++i, on = !on )
+        bench_peer_emit_display(peer, on);
+    bench_wait_count(&count, n);
+
+    mce_recorder_free(recorder);
+    mce_display_remove_handler(display, id);
+    mce_display_unref(display);
+    mce_proxy_unref(proxy);
+    bench_peer_delete(peer);
+}
+
+/* ========================================================================= *
+ * REPLAY
+ * ========================================================================= */
+
+static void noop_cb(MceDisplay *display, void *arg)
+{
+    (void)display, (void)arg;
+}
+
+static void replay(const char *path, const char *name, unsigned handlers,
+                   bool callbacks)
+{
+    GError    *error  = NULL;
+    MceReplay *replay = mce_replay_new(path, &error);
+    gulong     id[BENCH_MAX_HANDLERS];
+    unsigned   count  = 0;
+
+    if( !replay ) {
+        fprintf(stderr, "%s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+
+    MceDisplay *display = mce_display_new_for_proxy(mce_replay_proxy(replay));
+
+    /* Keeps the display tracked even with no state handlers */
+    gulong valid_id = mce_display_add_valid_changed_callback(display,
+                                                             noop_cb, NULL);
+    for( unsigned i = 0; i < handlers; ++i ) {
+        id[i] = (callbacks ?
+                 mce_display_add_state_changed_callback(display, count_cb,
+                                                        &count) :
+                 mce_display_add_state_changed_handler(display, count_cb,
+                                                       &count));
+    }
+
+    unsigned n   = mce_replay_count(replay);
+    gint64   cpu = bench_cputime();
+    mce_replay_run(replay);
+    cpu = bench_cputime() - cpu;
+
+    printf("%-8s %3u handlers %8.1f ns per update (%u calls)\n",
+           name, handlers, cpu * 1000.0 / n, count);
+
+    for( unsigned i = 0; i < handlers; ++i ) {
+        if( callbacks )
+            mce_display_remove_callback(display, id[i]);
+        else
+            mce_display_remove_handler(display, id[i]);
+    }
+    mce_display_remove_callback(display, valid_id);
+    mce_display_unref(display);
+    mce_replay_free(replay);
+}
+
+/* ========================================================================= *
+ * MAIN
+ * ========================================================================= */
+
+int main(int argc, char **argv)
+{
+    static const unsigned handlers[] = { 1, 10, BENCH_MAX_HANDLERS };
+
+    unsigned  n    = ((argc > 1) ?
+                      (unsigned)strtoul(argv[1], NULL, 0) : 100000);
+    char     *path = g_build_filename(g_get_tmp_dir(),
+                                      "bench_callbacks.XXXXXX", NULL);
+    int       fd   = g_mkstemp(path);
+
+    if( fd < 0 ) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    record(path, n);
+
+    /* The first run warms things up */
+    replay(path, "warmup", 1, false);
+    replay(path, "none", 0, false);
+    for( size_t i = 0; i < G_N_ELEMENTS(handlers); ++i ) {
+        replay(path, "gsignal", handlers[i], false);
+        replay(path, "callback", handlers[i], true);
+    }
+
+    unlink(path);
+    g_free(path);
+    return EXIT_SUCCESS;
+}
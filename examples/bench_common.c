@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "bench_common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include <mce/dbus-names.h>
+#include <mce/mode-names.h>
+
+/* ========================================================================= *
+ * PEER
+ * ========================================================================= */
+
+struct bench_peer_t
+{
+    GDBusConnection *server;
+    GDBusConnection *client;
+    guint            object_id;
+    bool             display_on;
+};
+
+static const char bench_peer_xml[] =
+    "<node>"
+    "  <interface name='" MCE_REQUEST_IF "'>"
+    "    <method name='" MCE_DISPLAY_STATUS_GET "'>"
+    "      <arg direction='out' type='s'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static void bench_peer_method_cb(GDBusConnection *connection,
+                                 const char *sender,
+                                 const char *path,
+                                 const char *iface,
+                                 const char *method,
+                                 GVariant *args,
+                                 GDBusMethodInvocation *call,
+                                 gpointer user_data)
+{
+    bench_peer_t *peer = user_data;
+
+    (void)connection, (void)sender, (void)path, (void)iface, (void)args;
+
+    if( !g_strcmp0(method, MCE_DISPLAY_STATUS_GET) ) {
+        const char *status = (peer->display_on ?
+                              MCE_DISPLAY_ON_STRING :
+                              MCE_DISPLAY_OFF_STRING);
+        g_dbus_method_invocation_return_value(call,
+                                              g_variant_new("(s)", status));
+    }
+    else {
+        g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+                                              G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "%s", method);
+    }
+}
+
+static void bench_peer_server_ready_cb(GObject *object, GAsyncResult *res,
+                                       gpointer user_data)
+{
+    GDBusConnection **server = user_data;
+    GError          *error   = NULL;
+
+    (void)object;
+
+    if( !(*server = g_dbus_connection_new_finish(res, &error)) ) {
+        fprintf(stderr, "peer: %s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static GIOStream *bench_peer_stream(int fd)
+{
+    GError  *error  = NULL;
+    GSocket *socket = g_socket_new_from_fd(fd, &error);
+
+    if( !socket ) {
+        fprintf(stderr, "peer: %s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+
+    GIOStream *stream =
+        G_IO_STREAM(g_socket_connection_factory_create_connection(socket));
+    g_object_unref(socket);
+    return stream;
+}
+
+bench_peer_t *bench_peer_create(void)
+{
+    static const GDBusInterfaceVTable vtable = {
+        .method_call = bench_peer_method_cb,
+    };
+
+    bench_peer_t    *peer  = g_new0(bench_peer_t, 1);
+    GError          *error = NULL;
+    int              fd[2];
+
+    if( socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0 ) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+
+    GIOStream *server_stream = bench_peer_stream(fd[0]);
+    GIOStream *client_stream = bench_peer_stream(fd[1]);
+    char      *guid          = g_dbus_generate_guid();
+
+    /* Both ends have to authenticate at the same time */
+    g_dbus_connection_new(server_stream, guid,
+                          G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER,
+                          NULL, NULL, bench_peer_server_ready_cb,
+                          &peer->server);
+    peer->client = g_dbus_connection_new_sync(client_stream, NULL,
+                          G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                          NULL, NULL, &error);
+    if( !peer->client ) {
+        fprintf(stderr, "peer: %s\n", error->message);
+        exit(EXIT_FAILURE);
+    }
+    while( !peer->server )
+        g_main_context_iteration(NULL, true);
+
+    GDBusNodeInfo *node = g_dbus_node_info_new_for_xml(bench_peer_xml, NULL);
+    peer->object_id =
+        g_dbus_connection_register_object(peer->server, MCE_REQUEST_PATH,
+                                          node->interfaces[0], &vtable,
+                                          peer, NULL, NULL);
+    g_dbus_node_info_unref(node);
+
+    g_free(guid);
+    g_object_unref(server_stream);
+    g_object_unref(client_stream);
+    return peer;
+}
+
+void bench_peer_delete(bench_peer_t *peer)
+{
+    if( peer ) {
+        g_dbus_connection_unregister_object(peer->server, peer->object_id);
+        g_dbus_connection_close_sync(peer->client, NULL, NULL);
+        g_object_unref(peer->client);
+        g_object_unref(peer->server);
+        g_free(peer);
+    }
+}
+
+GDBusConnection *bench_peer_client(bench_peer_t *peer)
+{
+    return peer->client;
+}
+
+void bench_peer_emit_display(bench_peer_t *peer, bool on)
+{
+    peer->display_on = on;
+    g_dbus_connection_emit_signal(peer->server, NULL, MCE_SIGNAL_PATH,
+                                  MCE_SIGNAL_IF, MCE_DISPLAY_SIG,
+                                  g_variant_new("(s)", on ?
+                                                MCE_DISPLAY_ON_STRING :
+                                                MCE_DISPLAY_OFF_STRING),
+                                  NULL);
+}
+
+/* ========================================================================= *
+ * MEASUREMENTS
+ * ========================================================================= */
+
+gint64 bench_cputime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * G_GINT64_CONSTANT(1000000) + ts.tv_nsec / 1000;
+}
+
+void bench_wait_count(const unsigned *counter, unsigned target)
+{
+    while( *counter < target )
+        g_main_context_iteration(NULL, true);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef BENCH_COMMON_H_
+# define BENCH_COMMON_H_
+
+# include <stdbool.h>
+
+# include <gio/gio.h>
+
+/* ========================================================================= *
+ * Fake mce peer for the benchmarks
+ *
+ * The peer sits on the other end of a peer-to-peer D-Bus connection,
+ * answers display status queries and emits display status signals.
+ * The client end can be passed to mce_proxy_new_for_connection(),
+ * so the benchmarks don't need the system bus or a running mce.
+ * ========================================================================= */
+
+typedef struct bench_peer_t bench_peer_t;
+
+bench_peer_t    *bench_peer_create      (void);
+void             bench_peer_delete      (bench_peer_t *peer);
+GDBusConnection *bench_peer_client      (bench_peer_t *peer);
+void             bench_peer_emit_display(bench_peer_t *peer, bool on);
+
+/* ========================================================================= *
+ * Measurements
+ * ========================================================================= */
+
+/* CPU time used by the whole process (all threads), in microseconds */
+gint64           bench_cputime          (void);
+
+/* Iterates the default context until *counter reaches the target */
+void             bench_wait_count       (const unsigned *counter,
+                                         unsigned target);
+
+#endif /* BENCH_COMMON_H_ */
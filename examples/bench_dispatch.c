@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Measures the CPU cost of delivering one display status signal from
+ * the (fake) mce peer to a handler:
+ *
+ *   gdbus  - the way it used to be done: GDBusProxy demultiplexes the
+ *            signal, the argument is converted to a GValue (copying
+ *            the string) and re-emitted through a GObject signal with
+ *            the generic marshaller, like gdbus-codegen proxies do
+ *   mce    - MceDisplay on top of MceProxy, which subscribes to the
+ *            signal directly and decodes it in place
+ *
+ * The cost includes the D-Bus transport, which is the same for both.
+ *
+ * Usage: bench_dispatch [count]
+ */
+
+#include "bench_common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mce/dbus-names.h>
+
+#include <mce_display.h>
+#include <mce_proxy.h>
+
+/* ========================================================================= *
+ * GENERATED PROXY STAND-IN
+ * ========================================================================= */
+
+typedef GObject      BenchSignal;
+typedef GObjectClass BenchSignalClass;
+
+G_DEFINE_TYPE(BenchSignal, bench_signal, G_TYPE_OBJECT)
+
+static guint bench_signal_display_status_ind = 0;
+
+static void bench_signal_init(BenchSignal *self)
+{
+    (void)self;
+}
+
+static void bench_signal_class_init(BenchSignalClass *klass)
+{
+    /* NULL marshaller means the generic one, as in generated code */
+    bench_signal_display_status_ind =
+        g_signal_new("display-status-ind", G_OBJECT_CLASS_TYPE(klass),
+                     G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
+                     G_TYPE_NONE, 1, G_TYPE_STRING);
+}
+
+static void gdbus_g_signal_cb(GDBusProxy *proxy, const char *sender,
+                              const char *signal, GVariant *args,
+                              gpointer user_data)
+{
+    GValue values[2] = { G_VALUE_INIT, G_VALUE_INIT };
+
+    (void)proxy, (void)sender;
+
+    if( g_strcmp0(signal, MCE_DISPLAY_SIG) ||
+        !g_variant_is_of_type(args, G_VARIANT_TYPE("(s)")) )
+        return;
+
+    GVariant *child = g_variant_get_child_value(args, 0);
+    g_value_init(&values[0], G_TYPE_OBJECT);
+    g_value_set_object(&values[0], user_data);
+    g_dbus_gvariant_to_gvalue(child, &values[1]);
+    g_variant_unref(child);
+    g_signal_emitv(values, bench_signal_display_status_ind, 0, NULL);
+    g_value_unset(&values[0]);
+    g_value_unset(&values[1]);
+}
+
+static void gdbus_display_status_cb(BenchSignal *object, const char *status,
+                                    gpointer user_data)
+{
+    unsigned *count = user_data;
+
+    (void)object, (void)status;
+    ++*count;
+}
+
+/* ========================================================================= *
+ * MCE
+ * ========================================================================= */
+
+static void mce_display_cb(MceDisplay *display, void *arg)
+{
+    unsigned *count = arg;
+
+    (void)display;
+    ++*count;
+}
+
+static void mce_valid_cb(MceDisplay *display, void *arg)
+{
+    (void)display, (void)arg;
+}
+
+/* ========================================================================= *
+ * MAIN
+ * ========================================================================= */
+
+static unsigned emitted = 0;
+
+static void run(const char *name, bench_peer_t *peer, const unsigned *count,
+                unsigned n)
+{
+    /* Every signal flips the state, so that each one gets reported */
+    gint64 cpu  = bench_cputime();
+    gint64 wall = g_get_monotonic_time();
+    unsigned base = *count;
+
+    for( unsigned i = 0; i < n; ++i )
+        bench_peer_emit_display(peer, !(emitted++ & 1));
+    bench_wait_count(count, base + n);
+
+    cpu  = bench_cputime() - cpu;
+    wall = g_get_monotonic_time() - wall;
+    printf("%-6s %8u signals %8.3f us cpu %8.3f us wall per signal\n",
+           name, n, (double)cpu / n, (double)wall / n);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned n = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 0) : 100000;
+    unsigned warmup = n / 10 + 1;
+    bench_peer_t *peer = bench_peer_create();
+    GDBusConnection *bus = bench_peer_client(peer);
+    GError *error = NULL;
+    unsigned count;
+
+    /* Before */
+    BenchSignal *object = g_object_new(bench_signal_get_type(), NULL);
+    GDBusProxy *gproxy =
+        g_dbus_proxy_new_sync(bus,
+                              G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                              G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                              NULL, NULL, MCE_SIGNAL_PATH, MCE_SIGNAL_IF,
+                              NULL, &error);
+    if( !gproxy ) {
+        fprintf(stderr, "%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    count = 0;
+    gulong gsignal_id = g_signal_connect(gproxy, "g-signal",
+                                         G_CALLBACK(gdbus_g_signal_cb),
+                                         object);
+    g_signal_connect(object, "display-status-ind",
+                     G_CALLBACK(gdbus_display_status_cb), &count);
+    run("warmup", peer, &count, warmup);
+    run("gdbus", peer, &count, n);
+    g_signal_handler_disconnect(gproxy, gsignal_id);
+    g_object_unref(gproxy);
+    g_object_unref(object);
+
+    /* After */
+    MceProxy *proxy = mce_proxy_new_for_connection(bus, NULL, NULL, NULL);
+    MceDisplay *display = mce_display_new_for_proxy(proxy);
+    gulong id[2];
+
+    count = 0;
+    id[0] = mce_display_add_valid_changed_handler(display, mce_valid_cb,
+                                                  NULL);
+    while( !display->valid )
+        g_main_context_iteration(NULL, true);
+
+    /* The initial query reported the current state */
+    emitted = (display->state == MCE_DISPLAY_STATE_ON);
+    id[1] = mce_display_add_state_changed_handler(display, mce_display_cb,
+                                                  &count);
+    run("warmup", peer, &count, warmup);
+    run("mce", peer, &count, n);
+    mce_display_remove_all_handlers(display, id);
+    mce_display_unref(display);
+    mce_proxy_unref(proxy);
+
+    bench_peer_delete(peer);
+    return EXIT_SUCCESS;
+}
@@ -76,6 +76,42 @@ static int mainloop_run(void)
     return mainloop_result;
 }
 
+/* ========================================================================= *
+ * STARTUP
+ * ========================================================================= */
+
+enum {
+    STARTUP_BATTERY    = 1 << 0,
+    STARTUP_CHARGER    = 1 << 1,
+    STARTUP_DISPLAY    = 1 << 2,
+    STARTUP_TKLOCK     = 1 << 3,
+    STARTUP_INACTIVITY = 1 << 4,
+    STARTUP_ALL        = (1 << 5) - 1,
+};
+
+static gint64   startup_time  = 0;
+static unsigned startup_valid = 0;
+
+static void startup_begin(void)
+{
+    startup_time = g_get_monotonic_time();
+}
+
+static void startup_update(unsigned bit, bool valid)
+{
+    if( valid )
+        startup_valid |= bit;
+    else
+        startup_valid &= ~bit;
+
+    /* Report how long it took for everything to become valid */
+    if( startup_time && startup_valid == STARTUP_ALL ) {
+        printf("all valid in %.1f ms\n",
+               (g_get_monotonic_time() - startup_time) / 1000.0);
+        startup_time = 0;
+    }
+}
+
 /* ========================================================================= *
  * STATUS
  * ========================================================================= */
@@ -139,6 +175,7 @@ static void battery_cb(MceBattery *battery, void *arg)
            battery->level,
            battery_status_repr(battery->status),
            what_changed);
+    startup_update(STARTUP_BATTERY, battery->valid);
 }
 
 static void charger_cb(MceCharger *charger, void *arg)
@@ -148,6 +185,7 @@ static void charger_cb(MceCharger *charger, void *arg)
            bool_repr(charger->valid),
            charger_state_repr(charger->state),
            what_changed);
+    startup_update(STARTUP_CHARGER, charger->valid);
 }
 
 static void display_cb(MceDisplay *display, void *arg)
@@ -157,6 +195,7 @@ static void display_cb(MceDisplay *display, void *arg)
            bool_repr(display->valid),
            display_state_repr(display->state),
            what_changed);
+    startup_update(STARTUP_DISPLAY, display->valid);
 }
 
 static void tklock_cb(MceTklock *tklock, void *arg)
@@ -167,6 +206,7 @@ static void tklock_cb(MceTklock *tklock, void *arg)
            tklock_mode_repr(tklock->mode),
            bool_repr(tklock->locked),
            what_changed);
+    startup_update(STARTUP_TKLOCK, tklock->valid);
 }
 
 static void inactivity_cb(MceInactivity *inactivity, void *arg)
@@ -176,6 +216,7 @@ static void inactivity_cb(MceInactivity *inactivity, void *arg)
            bool_repr(inactivity->valid),
            bool_repr(inactivity->status),
            what_changed);
+    startup_update(STARTUP_INACTIVITY, inactivity->valid);
 }
 
 /* ========================================================================= *
@@ -198,6 +239,8 @@ main(int argc, char **argv)
 
     int exitcode = EXIT_FAILURE;
 
+    startup_begin();
+
     MceBattery *battery = mce_battery_new();
     gulong battery_valid_id =
         mce_battery_add_valid_changed_handler(battery, battery_cb, "valid");
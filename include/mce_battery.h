@@ -39,9 +39,10 @@
 
 /* Since 1.0.6 */
 
+#include "mce_history.h"
 #include "mce_types.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,8 @@ struct mce_battery {
     gboolean valid;
     guint level;
     MCE_BATTERY_STATUS status;
+    MceStamp level_stamp;   /* Since 1.2.0 */
+    MceStamp status_stamp;  /* Since 1.2.0 */
 }; /* MceBattery */
 
 typedef void
@@ -68,10 +71,24 @@ typedef void
     MceBattery* battery,
     void* arg);
 
+typedef void
+(*MceBatteryThresholdFunc)(
+    MceBattery* battery,
+    gboolean below,
+    void* arg); /* Since 1.2.0 */
+
 MceBattery*
 mce_battery_new(
     void);
 
+MceBattery*
+mce_battery_new_for_proxy(
+    MceProxy* proxy); /* Since 1.2.0 */
+
+MceBattery*
+mce_battery_new_sync(
+    guint timeout_ms); /* Since 1.2.0 */
+
 MceBattery*
 mce_battery_ref(
     MceBattery* battery);
@@ -80,24 +97,53 @@ void
 mce_battery_unref(
     MceBattery* battery);
 
+/*
+ * The object returned by mce_battery_new() tracks both level and
+ * status, and it's valid when both are known.
+ *
+ * The one returned by mce_battery_new_for_proxy() tracks level and
+ * status independently of each other, depending on which handlers
+ * are connected. The valid handler alone makes both of them tracked,
+ * together with a level or status handler it doesn't add anything.
+ * The valid flag means that whatever is being tracked is known.
+ */
+
 gulong
 mce_battery_add_valid_changed_handler(
     MceBattery* battery,
     MceBatteryFunc fn,
     void* arg);
 
+gulong
+mce_battery_add_valid_changed_handler_in_context(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_battery_add_level_changed_handler(
     MceBattery* battery,
     MceBatteryFunc fn,
     void* arg);
 
+gulong
+mce_battery_add_level_changed_handler_in_context(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_battery_add_status_changed_handler(
     MceBattery* battery,
     MceBatteryFunc fn,
     void* arg);
 
+gulong
+mce_battery_add_status_changed_handler_in_context(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 void
 mce_battery_remove_handler(
     MceBattery* battery,
@@ -109,6 +155,79 @@ mce_battery_remove_handlers(
     gulong* ids,
     guint count);
 
+gulong
+mce_battery_add_valid_changed_callback(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_battery_add_level_changed_callback(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_battery_add_status_changed_callback(
+    MceBattery* battery,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_battery_remove_callback(
+    MceBattery* battery,
+    gulong id); /* Since 1.2.0 */
+
+/*
+ * Level watches are evaluated inside the library. A threshold watch
+ * fires when the level drops below the threshold and when it climbs
+ * back to threshold + hysteresis or higher. If the level is already
+ * below the threshold when it becomes known, the watch fires right
+ * away. A deadband watch fires when the level has moved by at least
+ * that many points since the last time it fired (or since the level
+ * became known). Both keep the level tracked. Watches are only evaluated
+ * while the battery is valid, and start over when it becomes invalid.
+ */
+gulong
+mce_battery_add_level_threshold_watch(
+    MceBattery* battery,
+    guint threshold,
+    guint hysteresis,
+    MceBatteryThresholdFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_battery_add_level_deadband_watch(
+    MceBattery* battery,
+    guint deadband,
+    MceBatteryFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_battery_remove_level_watch(
+    MceBattery* battery,
+    gulong id); /* Since 1.2.0 */
+
+void
+mce_battery_set_history(
+    MceBattery* battery,
+    MceHistory* history); /* Since 1.2.0 */
+
+/* See mce_wait.h */
+void
+mce_battery_wait_valid_async(
+    MceBattery* battery,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data); /* Since 1.2.0 */
+
+gboolean
+mce_battery_wait_valid_finish(
+    MceBattery* battery,
+    GAsyncResult* result,
+    GError** error); /* Since 1.2.0 */
+
 #define mce_battery_remove_all_handlers(d, ids) \
     mce_battery_remove_handlers(d, ids, G_N_ELEMENTS(ids))
 
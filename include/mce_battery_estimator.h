@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_BATTERY_ESTIMATOR_H
+#define MCE_BATTERY_ESTIMATOR_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Estimates the battery charge/discharge rate from the timestamps of
+ * the battery level changes. The rate is an exponentially weighted
+ * moving average of the rates between consecutive level changes, it
+ * takes constant time and memory to update. The estimate is reset
+ * whenever the charger state changes, and it becomes valid after two
+ * level changes since then.
+ *
+ * The confidence (0..1) grows with the number of samples and drops
+ * with their spread. Time to empty is only non-zero when the battery
+ * is discharging and time to full when it's charging.
+ *
+ * Like the other objects, it only tracks the state while it has
+ * handlers. The changed signal is emitted at most once per minimum
+ * interval (zero, the default, means no limit), the fields are always
+ * up to date.
+ */
+
+typedef struct mce_battery_estimator_priv MceBatteryEstimatorPriv;
+
+struct mce_battery_estimator {
+    GObject object;
+    MceBatteryEstimatorPriv* priv;
+    gboolean valid;
+    double rate;            /* Percent per hour, negative if discharging */
+    double confidence;
+    guint time_to_empty;    /* Seconds */
+    guint time_to_full;     /* Seconds */
+}; /* MceBatteryEstimator */
+
+typedef void
+(*MceBatteryEstimatorFunc)(
+    MceBatteryEstimator* estimator,
+    void* arg);
+
+MceBatteryEstimator*
+mce_battery_estimator_new(
+    void);
+
+MceBatteryEstimator*
+mce_battery_estimator_new_for_proxy(
+    MceProxy* proxy);
+
+MceBatteryEstimator*
+mce_battery_estimator_ref(
+    MceBatteryEstimator* estimator);
+
+void
+mce_battery_estimator_unref(
+    MceBatteryEstimator* estimator);
+
+gulong
+mce_battery_estimator_add_changed_handler(
+    MceBatteryEstimator* estimator,
+    MceBatteryEstimatorFunc fn,
+    void* arg);
+
+void
+mce_battery_estimator_remove_handler(
+    MceBatteryEstimator* estimator,
+    gulong id);
+
+void
+mce_battery_estimator_set_min_interval(
+    MceBatteryEstimator* estimator,
+    guint ms);
+
+G_END_DECLS
+
+#endif /* MCE_BATTERY_ESTIMATOR_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
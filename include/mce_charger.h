@@ -39,9 +39,10 @@
 
 /* Since 1.0.6 */
 
+#include "mce_history.h"
 #include "mce_types.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -58,6 +59,7 @@ struct mce_charger {
     MceChargerPriv* priv;
     gboolean valid;
     MCE_CHARGER_STATE state;
+    MceStamp state_stamp;   /* Since 1.2.0 */
 }; /* MceCharger */
 
 typedef void
@@ -65,10 +67,25 @@ typedef void
     MceCharger* charger,
     void* arg);
 
+typedef void
+(*MceChargerTransitionFunc)(
+    MceCharger* charger,
+    MCE_CHARGER_STATE from,
+    MCE_CHARGER_STATE to,
+    void* arg); /* Since 1.2.0 */
+
 MceCharger*
 mce_charger_new(
     void);
 
+MceCharger*
+mce_charger_new_for_proxy(
+    MceProxy* proxy); /* Since 1.2.0 */
+
+MceCharger*
+mce_charger_new_sync(
+    guint timeout_ms); /* Since 1.2.0 */
+
 MceCharger*
 mce_charger_ref(
     MceCharger* charger);
@@ -83,12 +100,24 @@ mce_charger_add_valid_changed_handler(
     MceChargerFunc fn,
     void* arg);
 
+gulong
+mce_charger_add_valid_changed_handler_in_context(
+    MceCharger* charger,
+    MceChargerFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_charger_add_state_changed_handler(
     MceCharger* charger,
     MceChargerFunc fn,
     void* arg);
 
+gulong
+mce_charger_add_state_changed_handler_in_context(
+    MceCharger* charger,
+    MceChargerFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 void
 mce_charger_remove_handler(
     MceCharger* charger,
@@ -100,6 +129,58 @@ mce_charger_remove_handlers(
     gulong* ids,
     guint count);
 
+gulong
+mce_charger_add_valid_changed_callback(
+    MceCharger* charger,
+    MceChargerFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_charger_add_state_changed_callback(
+    MceCharger* charger,
+    MceChargerFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+/*
+ * Only invoked for the state changes matching both masks, e.g.
+ * MCE_MASK(from) and MCE_MASK_ANY. The masks are checked before
+ * anything else gets invoked. The state field may not have been
+ * updated yet, the callback should use the arguments. Removed
+ * with mce_charger_remove_callback()
+ */
+gulong
+mce_charger_add_state_transition_callback(
+    MceCharger* charger,
+    guint from_mask,
+    guint to_mask,
+    MceChargerTransitionFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_charger_remove_callback(
+    MceCharger* charger,
+    gulong id); /* Since 1.2.0 */
+
+void
+mce_charger_set_history(
+    MceCharger* charger,
+    MceHistory* history); /* Since 1.2.0 */
+
+/* See mce_wait.h */
+void
+mce_charger_wait_valid_async(
+    MceCharger* charger,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data); /* Since 1.2.0 */
+
+gboolean
+mce_charger_wait_valid_finish(
+    MceCharger* charger,
+    GAsyncResult* result,
+    GError** error); /* Since 1.2.0 */
+
 #define mce_charger_remove_all_handlers(d, ids) \
     mce_charger_remove_handlers(d, ids, G_N_ELEMENTS(ids))
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_CHARGER_LOG_H
+#define MCE_CHARGER_LOG_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Keeps the last N charging sessions. A session starts when the
+ * charger gets connected and ends when it gets disconnected (or its
+ * state becomes unknown). If the charger gets connected again within
+ * the grace period (30 seconds by default), it's counted as an
+ * interruption of the same session rather than a new session. Until
+ * the grace period expires, the end of the last session is tentative.
+ *
+ * Times are CLOCK_BOOTTIME in microseconds, taken from the updates.
+ * The end level follows the battery level while the session is in
+ * progress, -1 means the level isn't known. A session which was in
+ * progress when the log got created starts when the charger state was
+ * first reported.
+ *
+ * The log keeps the charger and battery tracked for as long as it
+ * exists. It can be read from any thread.
+ */
+
+typedef struct mce_charger_log MceChargerLog;
+
+typedef struct mce_charger_session {
+    gint64 start;
+    gint64 end;             /* Zero while in progress */
+    gint64 time_to_full;    /* Zero if the battery never became full */
+    int start_level;
+    int end_level;
+    guint interruptions;
+} MceChargerSession;
+
+MceChargerLog*
+mce_charger_log_new(
+    MceProxy* proxy, /* Required, see mce_proxy_new() */
+    guint capacity);
+
+void
+mce_charger_log_free(
+    MceChargerLog* log);
+
+void
+mce_charger_log_set_grace_period(
+    MceChargerLog* log,
+    guint ms);
+
+guint
+mce_charger_log_count(
+    MceChargerLog* log);
+
+/* Copies up to max last sessions, oldest first, returns the count */
+guint
+mce_charger_log_copy(
+    MceChargerLog* log,
+    MceChargerSession* sessions,
+    guint max);
+
+G_END_DECLS
+
+#endif /* MCE_CHARGER_LOG_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
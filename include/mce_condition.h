@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_CONDITION_H
+#define MCE_CONDITION_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Condition source dispatches when a predicate over mce state turns
+ * from false to true. The predicate is a conjunction of terms, each
+ * comparing one input with a constant, e.g. display is off and
+ * charger is on and battery level is at least 50:
+ *
+ *   static const MceConditionTerm terms[] = {
+ *       { MCE_CONDITION_DISPLAY_STATE, MCE_CONDITION_EQ,
+ *         MCE_DISPLAY_STATE_OFF },
+ *       { MCE_CONDITION_CHARGER_STATE, MCE_CONDITION_EQ,
+ *         MCE_CHARGER_ON },
+ *       { MCE_CONDITION_BATTERY_LEVEL, MCE_CONDITION_GE, 50 }
+ *   };
+ *
+ *   MceProxy* proxy = mce_proxy_new();
+ *   GSource* src = mce_condition_source_new(proxy, terms,
+ *       G_N_ELEMENTS(terms));
+ *   g_source_set_callback(src, start_work, data, NULL);
+ *   g_source_attach(src, NULL);
+ *   g_source_unref(src);
+ *   mce_proxy_unref(proxy);
+ *
+ * Only the objects referenced by the terms are tracked, and a change
+ * only re-evaluates the terms which refer to the object that has
+ * changed. A term referring to an object which isn't (yet) valid is
+ * false. The predicate is initially considered false, i.e. the source
+ * fires as soon as it's found to be true. Several edges which occur
+ * before the source gets dispatched result in a single dispatch, and
+ * nothing is dispatched if the predicate is false again by then.
+ *
+ * The callback is a regular GSourceFunc, returning G_SOURCE_REMOVE
+ * destroys the source.
+ */
+
+typedef enum mce_condition_input {
+    MCE_CONDITION_BATTERY_LEVEL,        /* 0..100 */
+    MCE_CONDITION_BATTERY_STATUS,       /* MCE_BATTERY_STATUS */
+    MCE_CONDITION_CHARGER_STATE,        /* MCE_CHARGER_STATE */
+    MCE_CONDITION_DISPLAY_STATE,        /* MCE_DISPLAY_STATE */
+    MCE_CONDITION_TKLOCK_MODE,          /* MCE_TKLOCK_MODE */
+    MCE_CONDITION_TKLOCK_LOCKED,        /* TRUE/FALSE */
+    MCE_CONDITION_INACTIVITY_STATUS     /* TRUE/FALSE */
+} MCE_CONDITION_INPUT;
+
+typedef enum mce_condition_op {
+    MCE_CONDITION_EQ,
+    MCE_CONDITION_NE,
+    MCE_CONDITION_LT,
+    MCE_CONDITION_LE,
+    MCE_CONDITION_GT,
+    MCE_CONDITION_GE
+} MCE_CONDITION_OP;
+
+typedef struct mce_condition_term {
+    MCE_CONDITION_INPUT input;
+    MCE_CONDITION_OP op;
+    int value;
+} MceConditionTerm;
+
+/* The proxy is required (see mce_proxy_new()), terms are copied */
+GSource*
+mce_condition_source_new(
+    MceProxy* proxy,
+    const MceConditionTerm* terms,
+    guint count);
+
+G_END_DECLS
+
+#endif /* MCE_CONDITION_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
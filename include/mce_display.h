@@ -37,9 +37,10 @@
 #ifndef MCE_DISPLAY_H
 #define MCE_DISPLAY_H
 
+#include "mce_history.h"
 #include "mce_types.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -56,6 +57,7 @@ struct mce_display {
     MceDisplayPriv* priv;
     gboolean valid;
     MCE_DISPLAY_STATE state;
+    MceStamp state_stamp;   /* Since 1.2.0 */
 }; /* MceDisplay */
 
 typedef void
@@ -63,10 +65,25 @@ typedef void
     MceDisplay* display,
     void* arg);
 
+typedef void
+(*MceDisplayTransitionFunc)(
+    MceDisplay* display,
+    MCE_DISPLAY_STATE from,
+    MCE_DISPLAY_STATE to,
+    void* arg); /* Since 1.2.0 */
+
 MceDisplay*
 mce_display_new(
     void);
 
+MceDisplay*
+mce_display_new_for_proxy(
+    MceProxy* proxy); /* Since 1.2.0 */
+
+MceDisplay*
+mce_display_new_sync(
+    guint timeout_ms); /* Since 1.2.0 */
+
 MceDisplay*
 mce_display_ref(
     MceDisplay* display);
@@ -81,12 +98,24 @@ mce_display_add_valid_changed_handler(
     MceDisplayFunc fn,
     void* arg);
 
+gulong
+mce_display_add_valid_changed_handler_in_context(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_display_add_state_changed_handler(
     MceDisplay* display,
     MceDisplayFunc fn,
     void* arg);
 
+gulong
+mce_display_add_state_changed_handler_in_context(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 void
 mce_display_remove_handler(
     MceDisplay* display,
@@ -98,6 +127,78 @@ mce_display_remove_handlers(
     gulong* ids,
     guint count);
 
+gulong
+mce_display_add_valid_changed_callback(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_display_add_state_changed_callback(
+    MceDisplay* display,
+    MceDisplayFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+/*
+ * Only invoked for the state changes matching both masks, e.g.
+ * MCE_MASK(from) and MCE_MASK_ANY. The masks are checked before
+ * anything else gets invoked. The state field may not have been
+ * updated yet, the callback should use the arguments. Removed
+ * with mce_display_remove_callback()
+ */
+gulong
+mce_display_add_state_transition_callback(
+    MceDisplay* display,
+    guint from_mask,
+    guint to_mask,
+    MceDisplayTransitionFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_display_remove_callback(
+    MceDisplay* display,
+    gulong id); /* Since 1.2.0 */
+
+/*
+ * With non-zero window, state changes are held back for that many
+ * milliseconds after the first one and only the state in effect at
+ * the end of the window is reported. Transitions which never got
+ * reported (e.g. ON -> DIM -> ON) are counted as suppressed. Note
+ * that the display object is shared, and so is the window.
+ */
+void
+mce_display_set_coalesce_window(
+    MceDisplay* display,
+    guint ms); /* Since 1.2.0 */
+
+guint
+mce_display_get_suppressed_count(
+    MceDisplay* display); /* Since 1.2.0 */
+
+/*
+ * Transitions are recorded into the history (if any) as they are
+ * reported to the handlers. NULL detaches the history.
+ */
+void
+mce_display_set_history(
+    MceDisplay* display,
+    MceHistory* history); /* Since 1.2.0 */
+
+/* See mce_wait.h */
+void
+mce_display_wait_valid_async(
+    MceDisplay* display,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data); /* Since 1.2.0 */
+
+gboolean
+mce_display_wait_valid_finish(
+    MceDisplay* display,
+    GAsyncResult* result,
+    GError** error); /* Since 1.2.0 */
+
 #define mce_display_remove_all_handlers(d, ids) \
 	mce_display_remove_handlers(d, ids, G_N_ELEMENTS(ids))
 
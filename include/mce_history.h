@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_HISTORY_H
+#define MCE_HISTORY_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A fixed-size ring buffer of state transitions. It's allocated once,
+ * recording a transition takes constant time and never allocates any
+ * memory. When the buffer is full, the oldest records get overwritten.
+ *
+ * The same history may be attached to several objects, in which case
+ * it contains the transitions of all of them in the order in which
+ * they were reported. It may be read from any thread.
+ *
+ * The time and sequence number of a record are those of the report
+ * which has caused the transition, i.e. they match the MceStamp of
+ * the object. Transitions which weren't caused by a report (e.g. the
+ * object becoming invalid when mce is gone) get the current time.
+ */
+
+typedef enum mce_history_field {
+    MCE_HISTORY_BATTERY_VALID,
+    MCE_HISTORY_BATTERY_LEVEL,
+    MCE_HISTORY_BATTERY_STATUS,
+    MCE_HISTORY_CHARGER_VALID,
+    MCE_HISTORY_CHARGER_STATE,
+    MCE_HISTORY_DISPLAY_VALID,
+    MCE_HISTORY_DISPLAY_STATE,
+    MCE_HISTORY_TKLOCK_VALID,
+    MCE_HISTORY_TKLOCK_MODE,
+    MCE_HISTORY_TKLOCK_LOCKED,
+    MCE_HISTORY_INACTIVITY_VALID,
+    MCE_HISTORY_INACTIVITY_STATUS
+} MCE_HISTORY_FIELD;
+
+typedef struct mce_history_record {
+    gint64 time;        /* MceStamp time of the report */
+    guint seq;          /* MceStamp sequence number of the report */
+    MCE_HISTORY_FIELD field;
+    gint value;         /* The new value of the field */
+} MceHistoryRecord;
+
+typedef struct mce_history MceHistory;
+
+typedef struct mce_history_iter {
+    MceHistory* history;
+    guint64 pos;
+} MceHistoryIter;
+
+MceHistory*
+mce_history_new(
+    guint capacity);
+
+MceHistory*
+mce_history_ref(
+    MceHistory* history);
+
+void
+mce_history_unref(
+    MceHistory* history);
+
+guint
+mce_history_count(
+    MceHistory* history);
+
+/*
+ * Copies up to max most recent records, oldest first. Returns the
+ * number of records copied.
+ */
+guint
+mce_history_copy(
+    MceHistory* history,
+    MceHistoryRecord* records,
+    guint max);
+
+/*
+ * Iterates from the oldest record to the newest one. Records added
+ * while iterating are picked up too. If the iterator falls behind
+ * by more than the capacity, it skips to the oldest record still
+ * available. The iterator doesn't hold a reference to the history.
+ */
+void
+mce_history_iter_init(
+    MceHistoryIter* iter,
+    MceHistory* history);
+
+gboolean
+mce_history_iter_next(
+    MceHistoryIter* iter,
+    MceHistoryRecord* record);
+
+G_END_DECLS
+
+#endif /* MCE_HISTORY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
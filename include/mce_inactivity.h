@@ -36,9 +36,10 @@
 #ifndef MCE_INACTIVITY_H
 #define MCE_INACTIVITY_H
 
+#include "mce_history.h"
 #include "mce_types.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,7 @@ struct mce_inactivity {
     MceInactivityPriv* priv;
     gboolean valid;
     gboolean status;
+    MceStamp status_stamp;  /* Since 1.2.0 */
 }; /* MceInactivity */
 
 typedef void
@@ -60,6 +62,14 @@ MceInactivity*
 mce_inactivity_new(
     void);
 
+MceInactivity*
+mce_inactivity_new_for_proxy(
+    MceProxy* proxy); /* Since 1.2.0 */
+
+MceInactivity*
+mce_inactivity_new_sync(
+    guint timeout_ms); /* Since 1.2.0 */
+
 MceInactivity*
 mce_inactivity_ref(
     MceInactivity* inactivity);
@@ -74,12 +84,24 @@ mce_inactivity_add_valid_changed_handler(
     MceInactivityFunc fn,
     void* arg);
 
+gulong
+mce_inactivity_add_valid_changed_handler_in_context(
+    MceInactivity* inactivity,
+    MceInactivityFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_inactivity_add_status_changed_handler(
     MceInactivity* inactivity,
     MceInactivityFunc fn,
     void* arg);
 
+gulong
+mce_inactivity_add_status_changed_handler_in_context(
+    MceInactivity* inactivity,
+    MceInactivityFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 void
 mce_inactivity_remove_handler(
     MceInactivity* inactivity,
@@ -91,6 +113,43 @@ mce_inactivity_remove_handlers(
     gulong* ids,
     guint count);
 
+gulong
+mce_inactivity_add_valid_changed_callback(
+    MceInactivity* inactivity,
+    MceInactivityFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_inactivity_add_status_changed_callback(
+    MceInactivity* inactivity,
+    MceInactivityFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_inactivity_remove_callback(
+    MceInactivity* inactivity,
+    gulong id); /* Since 1.2.0 */
+
+void
+mce_inactivity_set_history(
+    MceInactivity* inactivity,
+    MceHistory* history); /* Since 1.2.0 */
+
+/* See mce_wait.h */
+void
+mce_inactivity_wait_valid_async(
+    MceInactivity* inactivity,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data); /* Since 1.2.0 */
+
+gboolean
+mce_inactivity_wait_valid_finish(
+    MceInactivity* inactivity,
+    GAsyncResult* result,
+    GError** error); /* Since 1.2.0 */
+
 #define mce_inactivity_remove_all_handlers(t, ids) \
         mce_inactivity_remove_handlers(t, ids, G_N_ELEMENTS(ids))
 
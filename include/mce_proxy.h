@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2016-2022 Jolla Ltd.
+ * Copyright (C) 2016-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_PROXY_H
+#define MCE_PROXY_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct mce_proxy_priv MceProxyPriv;
+
+struct mce_proxy {
+    GObject object;
+    MceProxyPriv* priv;
+    gboolean valid;
+}; /* MceProxy */
+
+typedef void
+(*MceProxyFunc)(
+    MceProxy* proxy,
+    void* arg);
+
+/*
+ * Failed state queries are retried with exponential backoff. The delay
+ * starts at initial_delay_ms, doubles with every attempt up to
+ * max_delay_ms and is randomly adjusted by up to jitter_percent in
+ * either direction. Zero call_timeout_ms means the default D-Bus
+ * timeout. Queries aren't retried if mce is not on the bus at all,
+ * those are repeated when mce shows up.
+ */
+typedef struct mce_proxy_retry_policy {
+    guint call_timeout_ms;
+    guint max_retries;
+    guint initial_delay_ms;
+    guint max_delay_ms;
+    guint jitter_percent;
+} MceProxyRetryPolicy;
+
+typedef struct mce_proxy_stats {
+    guint queries;      /* Calls submitted, including retries */
+    guint failures;     /* Calls failed (cancelled ones don't count) */
+    guint timeouts;     /* Calls timed out (included in failures) */
+    guint retries;      /* Retries scheduled */
+    guint gave_up;      /* Queries abandoned after all the retries */
+    guint disconnects;  /* Times the bus connection has closed */
+    guint reconnects;   /* Attempts to reconnect to the bus */
+    guint recoveries;   /* Times the state was restored after a close */
+    guint last_recovery_ms; /* From the close to the end of the resync */
+    guint max_recovery_ms;
+} MceProxyStats;
+
+/*
+ * mce_proxy_new() returns the shared proxy for the system bus mce,
+ * the one that's used by mce_battery_new(), mce_display_new() etc.
+ *
+ * mce_proxy_new_for_connection() creates a new, unshared proxy on
+ * the existing connection. NULL service, request_path and signal_path
+ * select the standard mce names. If the connection is a peer-to-peer
+ * one (i.e. it has no unique name) the service name is ignored and
+ * the peer is assumed to be mce. The proxy can then be passed to
+ * mce_battery_new_for_proxy(), mce_display_new_for_proxy() and so on.
+ *
+ * The objects returned by mce_battery_new(), mce_display_new() etc.
+ * keep tracking the state for as long as they exist, like they always
+ * did. Those returned by the *_new_for_proxy() functions are separate
+ * objects which only track the state (and the match rules for the
+ * corresponding mce signals are only installed) while they have at
+ * least one handler connected. Such an object without handlers stays
+ * invalid, and becomes invalid again when the last handler is removed.
+ *
+ * The proxy is bound to the thread-default main context of the thread
+ * that created it, that's where the state gets updated and the signals
+ * get emitted. Handlers may be added and removed on any thread though.
+ * Those added with the *_in_context() variants are invoked in the
+ * thread-default context of the thread that added them.
+ *
+ * The add_*_callback() functions register plain function pointers
+ * which bypass GSignal altogether. They get invoked right after the
+ * corresponding signal and are cheaper to call when things change
+ * often. Those are removed with the *_remove_callback() functions,
+ * the ids are not interchangeable with the signal handler ids.
+ *
+ * By default GDBus terminates the process when the system bus
+ * connection gets closed. Recovery from that is opt-in, see
+ * mce_proxy_set_reconnect() below.
+ */
+
+MceProxy*
+mce_proxy_new(
+    void);
+
+MceProxy*
+mce_proxy_new_for_connection(
+    GDBusConnection* bus,
+    const char* service,
+    const char* request_path,
+    const char* signal_path);
+
+MceProxy*
+mce_proxy_ref(
+    MceProxy* proxy);
+
+void
+mce_proxy_unref(
+    MceProxy* proxy);
+
+gulong
+mce_proxy_add_valid_changed_handler(
+    MceProxy* proxy,
+    MceProxyFunc fn,
+    void* arg);
+
+/*
+ * Each time mce (re)appears on the bus, the proxy queries the state
+ * which isn't known yet in a single batch. The resync done signal is
+ * emitted after the last reply in the batch has been applied (or the
+ * query has failed).
+ */
+gulong
+mce_proxy_add_resync_done_handler(
+    MceProxy* proxy,
+    MceProxyFunc fn,
+    void* arg);
+
+void
+mce_proxy_remove_handler(
+    MceProxy* proxy,
+    gulong id);
+
+/*
+ * Blocks until the state tracked by the objects attached to the proxy
+ * is known (or it becomes clear that mce is not there) but no longer
+ * than timeout_ms, by iterating the proxy's main context. Returns TRUE
+ * if the proxy is valid and everything that's being tracked is known.
+ * Since all the queries are submitted at once, it takes roughly one
+ * round trip. Must be called on the thread that created the proxy,
+ * while the context isn't being iterated by anyone else.
+ *
+ * mce_battery_new_sync(), mce_display_new_sync() and friends return
+ * the same objects as mce_battery_new() etc. after calling
+ * mce_proxy_sync() with the given timeout. With zero timeout they
+ * don't wait at all, e.g.
+ *
+ *   MceDisplay* display = mce_display_new_sync(0);
+ *   MceTklock* tklock = mce_tklock_new_sync(0);
+ *   MceProxy* proxy = mce_proxy_new();
+ *
+ *   mce_proxy_sync(proxy, 500);
+ *
+ * waits for both objects at once.
+ */
+gboolean
+mce_proxy_sync(
+    MceProxy* proxy,
+    guint timeout_ms); /* Since 1.2.0 */
+
+/* NULL policy restores the defaults */
+void
+mce_proxy_set_retry_policy(
+    MceProxy* proxy,
+    const MceProxyRetryPolicy* policy);
+
+/*
+ * With reconnect enabled, if the system bus connection used by the
+ * shared proxy gets closed, all the objects become invalid and the
+ * proxy keeps reconnecting (with the delays limited by the retry
+ * policy) until it succeeds. The handlers stay connected and the
+ * objects become valid again once the state is restored.
+ *
+ * Enabling it calls g_dbus_connection_set_exit_on_close() with FALSE
+ * on the system bus connection, which is shared by the whole process.
+ * Disabling it doesn't turn exit-on-close back on. It's disabled by
+ * default. Proxies created with mce_proxy_new_for_connection() never
+ * reconnect, they just become invalid.
+ */
+void
+mce_proxy_set_reconnect(
+    MceProxy* proxy,
+    gboolean reconnect);
+
+void
+mce_proxy_get_stats(
+    MceProxy* proxy,
+    MceProxyStats* stats);
+
+G_END_DECLS
+
+#endif /* MCE_PROXY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_RECORDER_H
+#define MCE_RECORDER_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The recorder appends every value decoded by the proxy to a file,
+ * one fixed-size binary record per value. Only the values which are
+ * being tracked (i.e. have handlers) get decoded and recorded. There
+ * can be only one recorder per proxy, mce_recorder_new() fails with
+ * G_IO_ERROR_BUSY if the proxy is already being recorded. The records
+ * are written to the file by a separate thread, mce_recorder_free()
+ * waits until all of them have been written.
+ *
+ * The replay maps the recording into memory and feeds it back through
+ * a proxy which has no D-Bus connection. Objects created for that
+ * proxy (with mce_battery_new_for_proxy() and such) go through exactly
+ * the same updates as they did when the recording was made, including
+ * the timestamps. The records can be replayed one by one, all at once
+ * or with the original timing, in the thread-default context.
+ */
+
+typedef struct mce_recorder MceRecorder;
+typedef struct mce_replay MceReplay;
+
+typedef void
+(*MceReplayFunc)(
+    MceReplay* replay,
+    void* arg);
+
+MceRecorder*
+mce_recorder_new(
+    MceProxy* proxy,
+    const char* path,
+    GError** error);
+
+void
+mce_recorder_free(
+    MceRecorder* recorder);
+
+MceReplay*
+mce_replay_new(
+    const char* path,
+    GError** error);
+
+void
+mce_replay_free(
+    MceReplay* replay);
+
+/* The proxy is owned by the replay, no need to unref it */
+MceProxy*
+mce_replay_proxy(
+    MceReplay* replay);
+
+guint
+mce_replay_count(
+    MceReplay* replay);
+
+/* Returns FALSE if there's nothing left */
+gboolean
+mce_replay_step(
+    MceReplay* replay);
+
+/* Replays the rest at once, returns the number of records replayed */
+guint
+mce_replay_run(
+    MceReplay* replay);
+
+/* Replays the rest with the original timing, then invokes done */
+void
+mce_replay_play(
+    MceReplay* replay,
+    MceReplayFunc done,
+    void* arg);
+
+void
+mce_replay_stop(
+    MceReplay* replay);
+
+G_END_DECLS
+
+#endif /* MCE_RECORDER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
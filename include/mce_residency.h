@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_RESIDENCY_H
+#define MCE_RESIDENCY_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Time spent in each state, in microseconds of CLOCK_BOOTTIME (i.e.
+ * including the time spent in suspend), indexed by the respective
+ * enum values. The time is accounted from the updates themselves,
+ * so short lived states aren't missed. Only the time when the state
+ * is known gets counted, and the state is only known while it's being
+ * tracked by at least one object (see mce_proxy.h).
+ *
+ * The totals are accumulated since the proxy was created, the window
+ * counters since the last snapshot which has reset the window. Taking
+ * a snapshot involves no allocations, all the counters are read at
+ * the same time.
+ */
+
+typedef struct mce_residency_times {
+    gint64 display[3];      /* MCE_DISPLAY_STATE */
+    gint64 tklock[7];       /* MCE_TKLOCK_MODE */
+    gint64 charger[3];      /* MCE_CHARGER_STATE */
+    gint64 inactivity[2];   /* FALSE (active) and TRUE (inactive) */
+} MceResidencyTimes;
+
+typedef struct mce_residency {
+    gint64 time;            /* When the snapshot was taken */
+    MceResidencyTimes total;
+    MceResidencyTimes window;
+} MceResidency;
+
+/*
+ * NULL proxy means the shared one, if it exists. If it doesn't, all
+ * the times are zero. The shared proxy is not created just for that.
+ */
+void
+mce_residency_snapshot(
+    MceProxy* proxy,
+    MceResidency* residency,
+    gboolean reset_window);
+
+G_END_DECLS
+
+#endif /* MCE_RESIDENCY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
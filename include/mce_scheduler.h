@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_SCHEDULER_H
+#define MCE_SCHEDULER_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Scheduler for postponable work. Jobs are started when conditions
+ * are favorable, i.e. the display is off, the user is inactive and
+ * the device is charging (or, if enabled, the battery level is high
+ * enough). All the jobs which can be started are started back to back
+ * in priority order (higher first) within a single main loop
+ * iteration. A job with a deadline is started when the deadline
+ * expires regardless of the conditions, and the jobs whose deadline
+ * falls within the batch window are started together with it.
+ * Deadlines include the time spent in suspend, a deadline which has
+ * expired while the device was suspended is noticed within a minute
+ * after resume.
+ *
+ * The run function returns TRUE if the job is finished, or FALSE if
+ * it continues asynchronously, in which case mce_scheduler_job_done()
+ * has to be called when it's done.
+ *
+ * When conditions become unfavorable, the preempt function is invoked
+ * for each running job (except those started by their deadline). If
+ * it returns TRUE, the job is supposed to stop and it goes back to
+ * the queue to be started again later. FALSE lets the job run to
+ * completion.
+ *
+ * Callbacks are invoked in the thread-default context of the thread
+ * which has created the scheduler. The scheduler is not thread-safe
+ * and must only be used on that thread.
+ */
+
+typedef struct mce_scheduler MceScheduler;
+
+typedef gboolean
+(*MceSchedulerJobFunc)(
+    MceScheduler* scheduler,
+    guint id,
+    void* arg);
+
+MceScheduler*
+mce_scheduler_new(
+    MceProxy* proxy); /* Required, see mce_proxy_new() */
+
+void
+mce_scheduler_free(
+    MceScheduler* scheduler);
+
+/* Zero deadline means none. The preempt function may be NULL. */
+guint
+mce_scheduler_add_job(
+    MceScheduler* scheduler,
+    int priority,
+    guint deadline_ms,
+    MceSchedulerJobFunc run,
+    MceSchedulerJobFunc preempt,
+    void* arg,
+    GDestroyNotify destroy);
+
+/* Removes the job without invoking any callbacks except destroy */
+gboolean
+mce_scheduler_cancel_job(
+    MceScheduler* scheduler,
+    guint id);
+
+void
+mce_scheduler_job_done(
+    MceScheduler* scheduler,
+    guint id);
+
+gboolean
+mce_scheduler_conditions_met(
+    MceScheduler* scheduler);
+
+/*
+ * Minimum battery level at which jobs can run without a charger.
+ * Anything above 100 (the default) means never.
+ */
+void
+mce_scheduler_set_battery_level(
+    MceScheduler* scheduler,
+    guint level);
+
+void
+mce_scheduler_set_batch_window(
+    MceScheduler* scheduler,
+    guint ms);
+
+G_END_DECLS
+
+#endif /* MCE_SCHEDULER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
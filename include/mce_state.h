@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_STATE_H
+#define MCE_STATE_H
+
+/* Since 1.2.0 */
+
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_tklock.h"
+
+G_BEGIN_DECLS
+
+/*
+ * MceState owns all five trackers and combines their state into a
+ * single snapshot. Changes are accumulated and reported once per main
+ * loop iteration, together with the mask of the fields that have
+ * changed since the previous notification. The snapshot is kept up
+ * to date at all times, the notification is just deferred.
+ */
+
+typedef enum mce_state_fields {
+    MCE_STATE_NONE              = 0x0000,
+    MCE_STATE_BATTERY_VALID     = 0x0001,
+    MCE_STATE_BATTERY_LEVEL     = 0x0002,
+    MCE_STATE_BATTERY_STATUS    = 0x0004,
+    MCE_STATE_CHARGER_VALID     = 0x0008,
+    MCE_STATE_CHARGER_STATE     = 0x0010,
+    MCE_STATE_DISPLAY_VALID     = 0x0020,
+    MCE_STATE_DISPLAY_STATE     = 0x0040,
+    MCE_STATE_TKLOCK_VALID      = 0x0080,
+    MCE_STATE_TKLOCK_MODE       = 0x0100,
+    MCE_STATE_TKLOCK_LOCKED     = 0x0200,
+    MCE_STATE_INACTIVITY_VALID  = 0x0400,
+    MCE_STATE_INACTIVITY_STATUS = 0x0800,
+    MCE_STATE_ALL               = 0x0fff
+} MCE_STATE_FIELDS;
+
+typedef struct mce_snapshot {
+    guint updates;      /* Incremented every time the snapshot changes */
+    gboolean battery_valid;
+    guint battery_level;
+    MCE_BATTERY_STATUS battery_status;
+    gboolean charger_valid;
+    MCE_CHARGER_STATE charger_state;
+    gboolean display_valid;
+    MCE_DISPLAY_STATE display_state;
+    gboolean tklock_valid;
+    MCE_TKLOCK_MODE tklock_mode;
+    gboolean tklock_locked;
+    gboolean inactivity_valid;
+    gboolean inactivity_status;
+} MceSnapshot;
+
+typedef struct mce_state_priv MceStatePriv;
+
+struct mce_state {
+    GObject object;
+    MceStatePriv* priv;
+    MceSnapshot snapshot;
+}; /* MceState */
+
+typedef void
+(*MceStateFunc)(
+    MceState* state,
+    MCE_STATE_FIELDS changed,
+    void* arg);
+
+MceState*
+mce_state_new(
+    void);
+
+MceState*
+mce_state_new_for_proxy(
+    MceProxy* proxy);
+
+MceState*
+mce_state_ref(
+    MceState* state);
+
+void
+mce_state_unref(
+    MceState* state);
+
+gulong
+mce_state_add_changed_handler(
+    MceState* state,
+    MceStateFunc fn,
+    void* arg);
+
+void
+mce_state_remove_handler(
+    MceState* state,
+    gulong id);
+
+/*
+ * Non-zero window delays the notification by that many milliseconds
+ * after the first change, merging everything that happens in between.
+ * The suppressed count is the number of updates which didn't get
+ * their own notification.
+ */
+void
+mce_state_set_coalesce_window(
+    MceState* state,
+    guint ms);
+
+guint
+mce_state_get_suppressed_count(
+    MceState* state);
+
+G_END_DECLS
+
+#endif /* MCE_STATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
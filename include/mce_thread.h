@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_THREAD_H
+#define MCE_THREAD_H
+
+/* Since 1.2.0 */
+
+#include "mce_state.h"
+
+G_BEGIN_DECLS
+
+/*
+ * MceThread runs its own mce proxy and trackers on a private thread,
+ * with its own GMainContext. The caller doesn't need to run a main
+ * loop. The state is published as a snapshot which can be fetched
+ * from any thread at any time. Readers never take a lock and never
+ * block the D-Bus thread.
+ */
+
+typedef struct mce_thread_priv MceThreadPriv;
+
+struct mce_thread {
+    GObject object;
+    MceThreadPriv* priv;
+}; /* MceThread */
+
+MceThread*
+mce_thread_new(
+    void);
+
+MceThread*
+mce_thread_ref(
+    MceThread* thread);
+
+/* Dropping the last reference stops the thread and waits for it */
+void
+mce_thread_unref(
+    MceThread* thread);
+
+void
+mce_thread_get_snapshot(
+    MceThread* thread,
+    MceSnapshot* snapshot);
+
+G_END_DECLS
+
+#endif /* MCE_THREAD_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
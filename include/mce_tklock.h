@@ -37,9 +37,10 @@
 #ifndef MCE_TKLOCK_H
 #define MCE_TKLOCK_H
 
+#include "mce_history.h"
 #include "mce_types.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,7 @@ struct mce_tklock {
     gboolean valid;
     MCE_TKLOCK_MODE mode;
     gboolean locked;
+    MceStamp mode_stamp;    /* Since 1.2.0 */
 }; /* MceTklock */
 
 typedef void
@@ -68,10 +70,25 @@ typedef void
     MceTklock* tklock,
     void* arg);
 
+typedef void
+(*MceTklockTransitionFunc)(
+    MceTklock* tklock,
+    MCE_TKLOCK_MODE from,
+    MCE_TKLOCK_MODE to,
+    void* arg); /* Since 1.2.0 */
+
 MceTklock*
 mce_tklock_new(
     void);
 
+MceTklock*
+mce_tklock_new_for_proxy(
+    MceProxy* proxy); /* Since 1.2.0 */
+
+MceTklock*
+mce_tklock_new_sync(
+    guint timeout_ms); /* Since 1.2.0 */
+
 MceTklock*
 mce_tklock_ref(
     MceTklock* tklock);
@@ -86,18 +103,36 @@ mce_tklock_add_valid_changed_handler(
     MceTklockFunc fn,
     void* arg);
 
+gulong
+mce_tklock_add_valid_changed_handler_in_context(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_tklock_add_mode_changed_handler(
     MceTklock* tklock,
     MceTklockFunc fn,
     void* arg);
 
+gulong
+mce_tklock_add_mode_changed_handler_in_context(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 gulong
 mce_tklock_add_locked_changed_handler(
     MceTklock* tklock,
     MceTklockFunc fn,
     void* arg);
 
+gulong
+mce_tklock_add_locked_changed_handler_in_context(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
 void
 mce_tklock_remove_handler(
     MceTklock* tklock,
@@ -109,6 +144,74 @@ mce_tklock_remove_handlers(
     gulong* ids,
     guint count);
 
+gulong
+mce_tklock_add_valid_changed_callback(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_tklock_add_mode_changed_callback(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+gulong
+mce_tklock_add_locked_changed_callback(
+    MceTklock* tklock,
+    MceTklockFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+/*
+ * Only invoked for the mode changes matching both masks, e.g.
+ * MCE_MASK(from) and MCE_MASK_ANY. The masks are checked before
+ * anything else gets invoked. The mode field may not have been
+ * updated yet, the callback should use the arguments. Removed
+ * with mce_tklock_remove_callback()
+ */
+gulong
+mce_tklock_add_mode_transition_callback(
+    MceTklock* tklock,
+    guint from_mask,
+    guint to_mask,
+    MceTklockTransitionFunc fn,
+    void* arg); /* Since 1.2.0 */
+
+void
+mce_tklock_remove_callback(
+    MceTklock* tklock,
+    gulong id); /* Since 1.2.0 */
+
+/* Works the same way as mce_display_set_coalesce_window() */
+void
+mce_tklock_set_coalesce_window(
+    MceTklock* tklock,
+    guint ms); /* Since 1.2.0 */
+
+guint
+mce_tklock_get_suppressed_count(
+    MceTklock* tklock); /* Since 1.2.0 */
+
+void
+mce_tklock_set_history(
+    MceTklock* tklock,
+    MceHistory* history); /* Since 1.2.0 */
+
+/* See mce_wait.h */
+void
+mce_tklock_wait_valid_async(
+    MceTklock* tklock,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data); /* Since 1.2.0 */
+
+gboolean
+mce_tklock_wait_valid_finish(
+    MceTklock* tklock,
+    GAsyncResult* result,
+    GError** error); /* Since 1.2.0 */
+
 #define mce_tklock_remove_all_handlers(t, ids) \
 	mce_tklock_remove_handlers(t, ids, G_N_ELEMENTS(ids))
 
@@ -42,11 +42,34 @@
 G_BEGIN_DECLS
 
 typedef struct mce_battery MceBattery;
+typedef struct mce_battery_estimator MceBatteryEstimator;
 typedef struct mce_charger MceCharger;
 typedef struct mce_display MceDisplay;
 typedef struct mce_inactivity MceInactivity;
+typedef struct mce_proxy MceProxy;
+typedef struct mce_state MceState;
+typedef struct mce_thread MceThread;
 typedef struct mce_tklock MceTklock;
 
+/*
+ * When the value was last reported by mce (CLOCK_BOOTTIME, in
+ * microseconds, taken when the D-Bus message was decoded) and the
+ * sequence number of that report. Each object numbers its reports
+ * separately, starting from one. Zeros mean nothing has been
+ * reported yet.
+ */
+typedef struct mce_stamp {
+    gint64 time;
+    guint seq;
+} MceStamp; /* Since 1.2.0 */
+
+/*
+ * Masks for transition callbacks, e.g. MCE_MASK(MCE_DISPLAY_STATE_DIM)
+ * or MCE_MASK(MCE_CHARGER_OFF) | MCE_MASK(MCE_CHARGER_UNKNOWN)
+ */
+#define MCE_MASK(value) (1u << (value)) /* Since 1.2.0 */
+#define MCE_MASK_ANY (~0u)              /* Since 1.2.0 */
+
 G_END_DECLS
 
 #endif /* MCE_TYPES_H */
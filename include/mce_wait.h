@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_WAIT_H
+#define MCE_WAIT_H
+
+/* Since 1.2.0 */
+
+#include "mce_types.h"
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * mce_battery_wait_valid_async() and friends complete when the object
+ * becomes valid (immediately if it already is), or fail with
+ * G_IO_ERROR_TIMED_OUT or G_IO_ERROR_CANCELLED. Zero timeout means
+ * no timeout. The object keeps tracking the state while the wait is
+ * pending and until the completion callback has returned, even if it
+ * has no handlers. Handlers connected by the callback keep it valid
+ * after that. Otherwise it becomes invalid again, unless it's one of
+ * the objects returned by mce_battery_new() and friends, those track
+ * the state for as long as they exist.
+ *
+ * mce_wait_ready_async() is a barrier which completes when all the
+ * selected objects of the proxy are valid. The proxy is required, the
+ * wait fails with G_IO_ERROR_INVALID_ARGUMENT without one:
+ *
+ *   mce_wait_ready_async(proxy, MCE_WAIT_DISPLAY | MCE_WAIT_TKLOCK,
+ *       1000, NULL, ready_cb, data);
+ *
+ * The objects are the same ones which mce_display_new_for_proxy() and
+ * friends return for that proxy, they stay pinned until the callback
+ * has returned. As usual, the callback is invoked in the thread-default
+ * context of the thread which started the wait.
+ */
+
+typedef enum mce_wait_objects {
+    MCE_WAIT_NONE       = 0x00,
+    MCE_WAIT_BATTERY    = 0x01,
+    MCE_WAIT_CHARGER    = 0x02,
+    MCE_WAIT_DISPLAY    = 0x04,
+    MCE_WAIT_INACTIVITY = 0x08,
+    MCE_WAIT_TKLOCK     = 0x10,
+    MCE_WAIT_ALL        = 0x1f
+} MCE_WAIT_OBJECTS;
+
+void
+mce_wait_ready_async(
+    MceProxy* proxy,
+    MCE_WAIT_OBJECTS objects,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data);
+
+gboolean
+mce_wait_ready_finish(
+    GAsyncResult* result,
+    GError** error);
+
+G_END_DECLS
+
+#endif /* MCE_WAIT_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -1,16 +1,17 @@
 Name: libmce-glib
 
-Version: 1.1.0
+Version: 1.2.0
 Release: 0
 Summary: MCE client library
 License: BSD
 URL: https://github.com/sailfishos/libmce-glib
 Source: %{name}-%{version}.tar.bz2
 
+%define glib_version 2.36
 %define libglibutil_version 1.0.5
 
 BuildRequires:  pkgconfig
-BuildRequires:  pkgconfig(glib-2.0)
+BuildRequires:  pkgconfig(glib-2.0) >= %{glib_version}
 BuildRequires: pkgconfig(libglibutil) >= %{libglibutil_version}
 BuildRequires:  pkgconfig(mce) >= 1.24.0
 
@@ -18,6 +19,7 @@ BuildRequires:  pkgconfig(mce) >= 1.24.0
 BuildRequires: pkgconfig(rpm)
 %define license_support %(pkg-config --exists 'rpm >= 4.11'; echo $?)
 
+Requires: glib2 >= %{glib_version}
 Requires: libglibutil >= %{libglibutil_version}
 Requires(post): /sbin/ldconfig
 Requires(postun): /sbin/ldconfig
@@ -35,7 +35,11 @@
  */
 
 #include "mce_battery.h"
-#include "mce_proxy.h"
+#include "mce_callbacks_p.h"
+#include "mce_context_p.h"
+#include "mce_history_p.h"
+#include "mce_proxy_p.h"
+#include "mce_wait_p.h"
 #include "mce_log_p.h"
 
 #include <mce/dbus-names.h>
@@ -43,10 +47,6 @@
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 enum mce_battery_ind {
     BATTERY_IND_LEVEL,
     BATTERY_IND_STATUS,
@@ -59,13 +59,39 @@ typedef enum mce_battery_flags {
     BATTERY_HAVE_STATUS = 0x02
 } BATTERY_FLAGS;
 
-#define BATTERY_HAVE_ALL (BATTERY_HAVE_LEVEL | BATTERY_HAVE_STATUS)
+/*
+ * Level watches are evaluated inside the library, the callbacks are
+ * only invoked when a threshold is crossed or the level has moved far
+ * enough. Zero deadband means it's a threshold watch.
+ */
+typedef struct mce_battery_level_watch {
+    gulong id;
+    GCallback fn;           /* NULL if removed during dispatch */
+    void* arg;
+    guint threshold;
+    guint hysteresis;
+    guint deadband;
+    gboolean below;         /* Threshold watch state */
+    gboolean have_baseline; /* Deadband watch state */
+    guint baseline;
+} MceBatteryLevelWatch;
 
 struct mce_battery_priv {
     MceProxy* proxy;
+    MceCallbacks callbacks;
+    guint seq;              /* Last MceStamp sequence number */
+    MceHistory* history;
+    gboolean eager;         /* Always tracked, see mce_battery_new() */
+    guint pins;             /* Tracked regardless of the handlers */
     BATTERY_FLAGS flags;
+    BATTERY_FLAGS tracked;
     gulong proxy_valid_id;
     gulong battery_ind_id[BATTERY_IND_COUNT];
+    MceBatteryLevelWatch* watches;
+    guint watch_count;
+    guint watch_active;     /* Not counting the removed ones */
+    guint watch_dispatching;
+    gulong last_watch_id;
 };
 
 enum mce_battery_signal {
@@ -81,6 +107,14 @@ enum mce_battery_signal {
 
 static guint mce_battery_signals[SIGNAL_COUNT] = { 0 };
 
+static const MCE_HISTORY_FIELD mce_battery_history_fields[] = {
+    MCE_HISTORY_BATTERY_VALID,
+    MCE_HISTORY_BATTERY_LEVEL,
+    MCE_HISTORY_BATTERY_STATUS
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_battery_history_fields) == SIGNAL_COUNT);
+
 typedef GObjectClass MceBatteryClass;
 G_DEFINE_TYPE(MceBattery, mce_battery, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_battery_parent_class
@@ -92,18 +126,168 @@ G_DEFINE_TYPE(MceBattery, mce_battery, G_TYPE_OBJECT)
  * Implementation
  *==========================================================================*/
 
+static
+void
+mce_battery_emit(
+    MceBattery* self,
+    enum mce_battery_signal sig)
+{
+    MceBatteryPriv* priv = self->priv;
+
+    if (priv->history) {
+        const MceStamp* stamp = NULL;
+        gint value = 0;
+
+        switch (sig) {
+        case SIGNAL_VALID_CHANGED:
+            value = self->valid;
+            /* Becoming valid is caused by the latest report */
+            if (self->valid) {
+                stamp = (self->level_stamp.seq > self->status_stamp.seq) ?
+                    &self->level_stamp : &self->status_stamp;
+            }
+            break;
+        case SIGNAL_LEVEL_CHANGED:
+            value = self->level;
+            stamp = &self->level_stamp;
+            break;
+        case SIGNAL_STATUS_CHANGED:
+            value = self->status;
+            stamp = &self->status_stamp;
+            break;
+        case SIGNAL_COUNT:
+            break;
+        }
+        mce_history_add(priv->history, mce_battery_history_fields[sig], value,
+            stamp, priv->seq);
+    }
+    g_signal_emit(self, mce_battery_signals[sig], 0);
+    mce_callbacks_emit(&priv->callbacks, sig, self);
+}
+
+static
+gboolean
+mce_battery_has_handlers(
+    MceBattery* self,
+    enum mce_battery_signal sig)
+{
+    MceBatteryPriv* priv = self->priv;
+
+    /* Level watches need the level to be tracked */
+    return (sig == SIGNAL_LEVEL_CHANGED && priv->watch_active) ||
+        mce_callbacks_has(&priv->callbacks, sig) ||
+        g_signal_has_handler_pending(self, mce_battery_signals[sig], 0,
+            TRUE);
+}
+
+static
+void
+mce_battery_watch_compact(
+    MceBatteryPriv* priv)
+{
+    guint i, n = 0;
+
+    for (i = 0; i < priv->watch_count; i++) {
+        if (priv->watches[i].fn) {
+            priv->watches[n++] = priv->watches[i];
+        }
+    }
+    priv->watch_count = n;
+    if (!n) {
+        g_free(priv->watches);
+        priv->watches = NULL;
+    }
+}
+
+static
+void
+mce_battery_watch_check(
+    MceBattery* self)
+{
+    MceBatteryPriv* priv = self->priv;
+    const guint level = self->level;
+    const guint count = priv->watch_count;
+    guint i;
+
+    /* The level may be stale until everything is known again */
+    if (!self->valid) {
+        return;
+    }
+
+    priv->watch_dispatching++;
+    for (i = 0; i < count; i++) {
+        /* The array may get reallocated by the callbacks */
+        MceBatteryLevelWatch* watch = priv->watches + i;
+
+        if (!watch->fn) {
+            continue;
+        } else if (watch->deadband) {
+            if (!watch->have_baseline) {
+                /* The first known level is the starting point */
+                watch->have_baseline = TRUE;
+                watch->baseline = level;
+            } else if ((level > watch->baseline) ?
+                (level - watch->baseline >= watch->deadband) :
+                (watch->baseline - level >= watch->deadband)) {
+                watch->baseline = level;
+                ((MceBatteryFunc)watch->fn)(self, watch->arg);
+            }
+        } else {
+            /*
+             * Going below the threshold fires right away, getting back
+             * above it requires the level to climb by the hysteresis.
+             */
+            const gboolean below = watch->below ?
+                (level < watch->threshold + watch->hysteresis) :
+                (level < watch->threshold);
+
+            if (watch->below != below) {
+                watch->below = below;
+                ((MceBatteryThresholdFunc)watch->fn)(self, below,
+                    watch->arg);
+            }
+        }
+    }
+    if (!--priv->watch_dispatching) {
+        mce_battery_watch_compact(priv);
+    }
+}
+
+static
+void
+mce_battery_watch_reset(
+    MceBatteryPriv* priv)
+{
+    guint i;
+
+    /* Start over, as if the watches had just been added */
+    for (i = 0; i < priv->watch_count; i++) {
+        MceBatteryLevelWatch* watch = priv->watches + i;
+
+        watch->below = FALSE;
+        watch->have_baseline = FALSE;
+    }
+}
+
 static
 void
 mce_battery_check_valid(
     MceBattery* self)
 {
     MceBatteryPriv* priv = self->priv;
-    const gboolean valid = priv->proxy->valid &&
-        (priv->flags & BATTERY_HAVE_ALL) == BATTERY_HAVE_ALL;
+    /* Valid means that everything that's being tracked is known */
+    const gboolean valid = priv->proxy->valid && priv->tracked &&
+        (priv->flags & priv->tracked) == priv->tracked;
 
     if (valid != self->valid) {
         self->valid = valid;
-        g_signal_emit(self, mce_battery_signals[SIGNAL_VALID_CHANGED], 0);
+        if (!valid) {
+            mce_battery_watch_reset(priv);
+        }
+        mce_battery_emit(self, SIGNAL_VALID_CHANGED);
+        if (valid) {
+            mce_battery_watch_check(self);
+        }
     }
 }
 
@@ -116,9 +300,11 @@ mce_battery_level_update(
     MceBatteryPriv* priv = self->priv;
     const guint new_level = (level < 0) ? 0 : (level > 100) ? 100 : level;
 
+    /* The first level gets evaluated when the battery becomes valid */
     if (self->level != new_level) {
         self->level = new_level;
-        g_signal_emit(self, mce_battery_signals[SIGNAL_LEVEL_CHANGED], 0);
+        mce_battery_emit(self, SIGNAL_LEVEL_CHANGED);
+        mce_battery_watch_check(self);
     }
     priv->flags |= BATTERY_HAVE_LEVEL;
     mce_battery_check_valid(self);
@@ -147,7 +333,7 @@ mce_battery_status_update(
     }
     if (self->status != new_status) {
         self->status = new_status;
-        g_signal_emit(self, mce_battery_signals[SIGNAL_STATUS_CHANGED], 0);
+        mce_battery_emit(self, SIGNAL_STATUS_CHANGED);
     }
     priv->flags |= BATTERY_HAVE_STATUS;
     mce_battery_check_valid(self);
@@ -155,106 +341,136 @@ mce_battery_status_update(
 
 static
 void
-mce_battery_level_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_battery_level_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
     MceBattery* self = MCE_BATTERY(arg);
-    GError* error = NULL;
-    gint level;
 
-    if (com_nokia_mce_request_call_get_battery_level_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &level, result, &error)) {
-        GDEBUG("Battery level is currently %d", level);
-        mce_battery_level_update(self, level);
-    } else {
-        /* Should retry? */
-        GWARN("Failed to query battery level %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_battery_unref(self);
+    GDEBUG("Battery level is %d", value->i);
+    self->level_stamp.time = value->time;
+    self->level_stamp.seq = ++self->priv->seq;
+    mce_battery_level_update(self, value->i);
 }
 
 static
 void
-mce_battery_status_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_battery_status_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
     MceBattery* self = MCE_BATTERY(arg);
-    GError* error = NULL;
-    char* status = NULL;
-
-    if (com_nokia_mce_request_call_get_battery_status_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &status, result, &error)) {
-        GDEBUG("Battery is currently %s", status);
-        mce_battery_status_update(self, status);
-        g_free(status);
-    } else {
-        /* Should retry? */
-        GWARN("Failed to query battery status %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_battery_unref(self);
-}
 
-static
-void
-mce_battery_level_ind(
-    ComNokiaMceSignal* proxy,
-    gint level,
-    gpointer arg)
-{
-    GDEBUG("Battery level is %d", level);
-    mce_battery_level_update(MCE_BATTERY(arg), level);
+    GDEBUG("Battery is %s", value->str);
+    self->status_stamp.time = value->time;
+    self->status_stamp.seq = ++self->priv->seq;
+    mce_battery_status_update(self, value->str);
 }
 
-static
-void
-mce_battery_status_ind(
-    ComNokiaMceSignal* proxy,
-    const char* status,
-    gpointer arg)
-{
-    GDEBUG("Battery is %s", status);
-    mce_battery_status_update(MCE_BATTERY(arg), status);
-}
+typedef struct mce_battery_ind_desc {
+    MCE_PROXY_PROPERTY property;
+    BATTERY_FLAGS flag;
+    enum mce_battery_signal signal;
+    MceProxySignalFunc ind;
+} MceBatteryIndDesc;
+
+static const MceBatteryIndDesc mce_battery_inds[] = {
+    {   /* BATTERY_IND_LEVEL */
+        MCE_PROXY_BATTERY_LEVEL, BATTERY_HAVE_LEVEL, SIGNAL_LEVEL_CHANGED,
+        mce_battery_level_ind
+    },{ /* BATTERY_IND_STATUS */
+        MCE_PROXY_BATTERY_STATUS, BATTERY_HAVE_STATUS, SIGNAL_STATUS_CHANGED,
+        mce_battery_status_ind
+    }
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_battery_inds) == BATTERY_IND_COUNT);
 
 static
 void
-mce_battery_query(
+mce_battery_update_demand(
     MceBattery* self)
 {
     MceBatteryPriv* priv = self->priv;
-    MceProxy* proxy = priv->proxy;
+    const gboolean want_all = priv->eager || priv->pins ||
+        (mce_battery_has_handlers(self, SIGNAL_VALID_CHANGED) &&
+        !mce_battery_has_handlers(self, SIGNAL_LEVEL_CHANGED) &&
+        !mce_battery_has_handlers(self, SIGNAL_STATUS_CHANGED));
+    int i;
 
     /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceBattery is created. In that case we have to wait
-     * for the valid signal before we can connect the battery state
-     * signal and submit the initial query.
+     * Level and status are tracked separately. Those who only care
+     * about the status don't have to wake up on every level change.
+     * The valid handler only needs both if nothing else says which
+     * one is actually needed.
      */
-    if (proxy->signal) {
-        if (!priv->battery_ind_id[BATTERY_IND_LEVEL]) {
-            priv->battery_ind_id[BATTERY_IND_LEVEL] =
-                g_signal_connect(proxy->signal, "battery-level-ind",
-                    G_CALLBACK(mce_battery_level_ind), self);
+    for (i = 0; i < BATTERY_IND_COUNT; i++) {
+        const MceBatteryIndDesc* ind = mce_battery_inds + i;
+
+        if (want_all || mce_battery_has_handlers(self, ind->signal)) {
+            if (!priv->battery_ind_id[i]) {
+                priv->battery_ind_id[i] =
+                    mce_proxy_add_signal_handler(priv->proxy,
+                        ind->property, ind->ind, self);
+                priv->tracked |= ind->flag;
+            }
+        } else if (priv->battery_ind_id[i]) {
+            mce_proxy_remove_signal_handler(priv->proxy, ind->property,
+                priv->battery_ind_id[i]);
+            priv->battery_ind_id[i] = 0;
+            priv->tracked &= ~ind->flag;
+            priv->flags &= ~ind->flag;
         }
+    }
+    mce_battery_check_valid(self);
+}
 
-        if (!priv->battery_ind_id[BATTERY_IND_STATUS]) {
-            priv->battery_ind_id[BATTERY_IND_STATUS] =
-                g_signal_connect(proxy->signal, "battery-status-ind",
-                    G_CALLBACK(mce_battery_status_ind), self);
-        }
+static
+gulong
+mce_battery_add_handler(
+    MceBattery* self,
+    const char* name,
+    MceBatteryFunc fn,
+    void* arg,
+    gboolean in_context)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = in_context ?
+            mce_context_connect(self, name, G_CALLBACK(fn), arg) :
+            g_signal_connect(self, name, G_CALLBACK(fn), arg);
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
-    if (proxy->request && proxy->valid) {
-        com_nokia_mce_request_call_get_battery_level(proxy->request, NULL,
-            mce_battery_level_query_done, mce_battery_ref(self));
-        com_nokia_mce_request_call_get_battery_status(proxy->request, NULL,
-            mce_battery_status_query_done, mce_battery_ref(self));
+    return 0;
+}
+
+static
+gulong
+mce_battery_add_callback(
+    MceBattery* self,
+    enum mce_battery_signal sig,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add(&self->priv->callbacks, sig, G_CALLBACK(fn),
+            arg);
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
+    return 0;
 }
 
 static
@@ -266,14 +482,97 @@ mce_battery_valid_changed(
     MceBattery* self = MCE_BATTERY(arg);
     MceBatteryPriv* priv = self->priv;
 
-    if (proxy->valid) {
-        mce_battery_query(self);
-    } else {
+    if (!proxy->valid) {
         priv->flags = BATTERY_HAVE_NONE;
     }
     mce_battery_check_valid(self);
 }
 
+static
+gulong
+mce_battery_add_watch(
+    MceBattery* self,
+    const MceBatteryLevelWatch* init)
+{
+    MceBatteryPriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+    MceBatteryLevelWatch* watch;
+    gulong id;
+
+    mce_proxy_lock(proxy);
+    priv->watches = g_renew(MceBatteryLevelWatch, priv->watches,
+        priv->watch_count + 1);
+    watch = priv->watches + (priv->watch_count++);
+    *watch = *init;
+    id = watch->id = ++priv->last_watch_id;
+    priv->watch_active++;
+    mce_battery_update_demand(self);
+    /* Pick up the current level (if it's known) */
+    mce_battery_watch_check(self);
+    mce_proxy_unlock(proxy);
+    return id;
+}
+
+static
+void
+mce_battery_pin(
+    gpointer object)
+{
+    MceBattery* self = MCE_BATTERY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    self->priv->pins++;
+    mce_battery_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+void
+mce_battery_unpin(
+    gpointer object)
+{
+    MceBattery* self = MCE_BATTERY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    GASSERT(self->priv->pins);
+    self->priv->pins--;
+    mce_battery_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+MceBattery*
+mce_battery_create(
+    MceProxy* proxy,
+    gboolean eager)
+{
+    /* Eager and lazy objects don't share the state */
+    const MCE_PROXY_OBJECT type = eager ?
+        MCE_PROXY_OBJECT_BATTERY_EAGER :
+        MCE_PROXY_OBJECT_BATTERY;
+    MceBattery* self;
+
+    /* MCE assumes one battery */
+    mce_proxy_lock(proxy);
+    self = mce_proxy_object_ref(proxy, type);
+    if (!self) {
+        MceBatteryPriv* priv;
+
+        self = g_object_new(MCE_BATTERY_TYPE, NULL);
+        priv = self->priv;
+        priv->proxy = mce_proxy_ref(proxy);
+        priv->eager = eager;
+        priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(proxy,
+            mce_battery_valid_changed, self);
+        mce_battery_update_demand(self);
+        mce_proxy_object_set(proxy, type, self);
+    }
+    mce_proxy_unlock(proxy);
+    return self;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -281,18 +580,30 @@ mce_battery_valid_changed(
 MceBattery*
 mce_battery_new()
 {
-    /* MCE assumes one battery */
-    static MceBattery* mce_battery_instance = NULL;
+    MceProxy* proxy = mce_proxy_new();
+    MceBattery* self = mce_battery_create(proxy, TRUE);
 
-    if (mce_battery_instance) {
-        mce_battery_ref(mce_battery_instance);
-    } else {
-        mce_battery_instance = g_object_new(MCE_BATTERY_TYPE, NULL);
-        mce_battery_query(mce_battery_instance);
-        g_object_add_weak_pointer(G_OBJECT(mce_battery_instance),
-            (gpointer*)(&mce_battery_instance));
-    }
-    return mce_battery_instance;
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceBattery*
+mce_battery_new_for_proxy(
+    MceProxy* proxy)
+{
+    return G_LIKELY(proxy) ? mce_battery_create(proxy, FALSE) : NULL;
+}
+
+MceBattery*
+mce_battery_new_sync(
+    guint timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceBattery* self = mce_battery_create(proxy, TRUE);
+
+    mce_proxy_sync(proxy, timeout_ms);
+    mce_proxy_unref(proxy);
+    return self;
 }
 
 MceBattery*
@@ -320,8 +631,18 @@ mce_battery_add_valid_changed_handler(
     MceBatteryFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_battery_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_battery_add_valid_changed_handler_in_context(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -330,8 +651,18 @@ mce_battery_add_level_changed_handler(
     MceBatteryFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_LEVEL_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_battery_add_handler(self, SIGNAL_LEVEL_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_battery_add_level_changed_handler_in_context(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_handler(self, SIGNAL_LEVEL_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -340,8 +671,18 @@ mce_battery_add_status_changed_handler(
     MceBatteryFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_STATUS_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_battery_add_handler(self, SIGNAL_STATUS_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_battery_add_status_changed_handler_in_context(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_handler(self, SIGNAL_STATUS_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 void
@@ -350,7 +691,12 @@ mce_battery_remove_handler(
     gulong id)
 {
     if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
         g_signal_handler_disconnect(self, id);
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
     }
 }
 
@@ -360,7 +706,166 @@ mce_battery_remove_handlers(
     gulong* ids,
     guint count)
 {
-    gutil_disconnect_handlers(self, ids, count);
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        gutil_disconnect_handlers(self, ids, count);
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_battery_add_valid_changed_callback(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_callback(self, SIGNAL_VALID_CHANGED, fn, arg);
+}
+
+gulong
+mce_battery_add_level_changed_callback(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_callback(self, SIGNAL_LEVEL_CHANGED, fn, arg);
+}
+
+gulong
+mce_battery_add_status_changed_callback(
+    MceBattery* self,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    return mce_battery_add_callback(self, SIGNAL_STATUS_CHANGED, fn, arg);
+}
+
+void
+mce_battery_remove_callback(
+    MceBattery* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        mce_callbacks_remove(&self->priv->callbacks, id);
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_battery_add_level_threshold_watch(
+    MceBattery* self,
+    guint threshold,
+    guint hysteresis,
+    MceBatteryThresholdFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceBatteryLevelWatch watch;
+
+        memset(&watch, 0, sizeof(watch));
+        watch.fn = G_CALLBACK(fn);
+        watch.arg = arg;
+        watch.threshold = threshold;
+        watch.hysteresis = hysteresis;
+        return mce_battery_add_watch(self, &watch);
+    }
+    return 0;
+}
+
+gulong
+mce_battery_add_level_deadband_watch(
+    MceBattery* self,
+    guint deadband,
+    MceBatteryFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceBatteryLevelWatch watch;
+
+        memset(&watch, 0, sizeof(watch));
+        watch.fn = G_CALLBACK(fn);
+        watch.arg = arg;
+        watch.deadband = MAX(deadband, 1);
+        return mce_battery_add_watch(self, &watch);
+    }
+    return 0;
+}
+
+void
+mce_battery_remove_level_watch(
+    MceBattery* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceBatteryPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+        guint i;
+
+        mce_proxy_lock(proxy);
+        for (i = 0; i < priv->watch_count; i++) {
+            MceBatteryLevelWatch* watch = priv->watches + i;
+
+            if (watch->id == id && watch->fn) {
+                watch->fn = NULL;
+                priv->watch_active--;
+                if (!priv->watch_dispatching) {
+                    mce_battery_watch_compact(priv);
+                }
+                break;
+            }
+        }
+        mce_battery_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_battery_set_history(
+    MceBattery* self,
+    MceHistory* history)
+{
+    if (G_LIKELY(self)) {
+        MceBatteryPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        if (priv->history != history) {
+            mce_history_unref(priv->history);
+            priv->history = mce_history_ref(history);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_battery_wait_valid_async(
+    MceBattery* self,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(self)) {
+        mce_wait_valid_async(self, SIGNAL_VALID_CHANGED_NAME, &self->valid,
+            mce_battery_pin, mce_battery_unpin, timeout_ms, cancellable,
+            callback, user_data);
+    }
+}
+
+gboolean
+mce_battery_wait_valid_finish(
+    MceBattery* self,
+    GAsyncResult* result,
+    GError** error)
+{
+    return mce_wait_valid_finish(self, result, error);
 }
 
 /*==========================================================================*
@@ -376,9 +881,28 @@ mce_battery_init(
         MceBatteryPriv);
 
     self->priv = priv;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_battery_valid_changed, self);
+}
+
+static
+void
+mce_battery_dispose(
+    GObject* object)
+{
+    MceBattery* self = MCE_BATTERY(object);
+    MceBatteryPriv* priv = self->priv;
+    int i;
+
+    /* The indications must stop before the last reference is gone */
+    mce_proxy_lock(priv->proxy);
+    for (i = 0; i < BATTERY_IND_COUNT; i++) {
+        mce_proxy_remove_signal_handler(priv->proxy,
+            mce_battery_inds[i].property, priv->battery_ind_id[i]);
+        priv->battery_ind_id[i] = 0;
+    }
+    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    priv->proxy_valid_id = 0;
+    mce_proxy_unlock(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
 }
 
 static
@@ -389,10 +913,10 @@ mce_battery_finalize(
     MceBattery* self = MCE_BATTERY(object);
     MceBatteryPriv* priv = self->priv;
 
-    gutil_disconnect_handlers(priv->proxy->signal, priv->battery_ind_id,
-        G_N_ELEMENTS(priv->battery_ind_id));
-    mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
     mce_proxy_unref(priv->proxy);
+    mce_callbacks_clear(&priv->callbacks);
+    mce_history_unref(priv->history);
+    g_free(priv->watches);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -403,6 +927,7 @@ mce_battery_class_init(
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
 
+    object_class->dispose = mce_battery_dispose;
     object_class->finalize = mce_battery_finalize;
     g_type_class_add_private(klass, sizeof(MceBatteryPriv));
     mce_battery_signals[SIGNAL_VALID_CHANGED] =
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_battery_estimator.h"
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_clock_p.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+#include <math.h>
+
+/* Weight of the latest sample */
+#define MCE_BATTERY_ESTIMATOR_ALPHA (0.25)
+
+/* Microseconds per hour */
+#define MCE_BATTERY_ESTIMATOR_HOUR (G_GINT64_CONSTANT(3600000000))
+
+/* Everything is protected by the proxy lock */
+struct mce_battery_estimator_priv {
+    MceProxy* proxy;
+    MceBattery* battery;
+    MceCharger* charger;
+    gulong battery_id[2];
+    gulong charger_id[2];
+    gboolean charger_known;
+    MCE_CHARGER_STATE charger_state;
+    gboolean level_known;
+    gboolean have_baseline; /* Level has changed since the reset */
+    guint level;            /* Level at the last change */
+    gint64 time;            /* And its CLOCK_BOOTTIME */
+    guint samples;          /* Since the last reset */
+    double decay;           /* (1 - alpha) ^ samples */
+    double variance;        /* Exponentially weighted */
+    guint min_interval_ms;
+    gint64 last_notify;
+    GSource* notify_timer;
+};
+
+enum mce_battery_estimator_signal {
+    SIGNAL_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_CHANGED_NAME     "mce-battery-estimator-changed"
+
+static guint mce_battery_estimator_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceBatteryEstimatorClass;
+G_DEFINE_TYPE(MceBatteryEstimator, mce_battery_estimator, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_battery_estimator_parent_class
+#define MCE_BATTERY_ESTIMATOR_TYPE (mce_battery_estimator_get_type())
+#define MCE_BATTERY_ESTIMATOR(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_BATTERY_ESTIMATOR_TYPE,MceBatteryEstimator))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_battery_estimator_emit(
+    MceBatteryEstimator* self)
+{
+    self->priv->last_notify = mce_clock_boottime();
+    g_signal_emit(self, mce_battery_estimator_signals[SIGNAL_CHANGED], 0);
+}
+
+static
+gboolean
+mce_battery_estimator_notify_timeout(
+    gpointer data)
+{
+    MceBatteryEstimator* self = MCE_BATTERY_ESTIMATOR(data);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    g_source_unref(self->priv->notify_timer);
+    self->priv->notify_timer = NULL;
+    mce_battery_estimator_emit(self);
+    mce_proxy_unlock(proxy);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_battery_estimator_notify(
+    MceBatteryEstimator* self)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    if (!priv->notify_timer) {
+        const gint64 interval = ((gint64)priv->min_interval_ms) * 1000;
+        const gint64 wait = priv->last_notify ?
+            (priv->last_notify + interval - mce_clock_boottime()) : 0;
+
+        if (wait > 0) {
+            /* The timer reports whatever the state is by then */
+            priv->notify_timer = g_timeout_source_new((guint)
+                ((wait + 999) / 1000));
+            g_source_set_callback(priv->notify_timer,
+                mce_battery_estimator_notify_timeout,
+                mce_battery_estimator_ref(self), g_object_unref);
+            g_source_attach(priv->notify_timer,
+                mce_proxy_context(priv->proxy));
+        } else {
+            mce_battery_estimator_emit(self);
+        }
+    }
+}
+
+static
+void
+mce_battery_estimator_reset(
+    MceBatteryEstimator* self)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    priv->have_baseline = FALSE;
+    priv->samples = 0;
+    priv->decay = 1;
+    priv->variance = 0;
+    if (self->valid) {
+        self->valid = FALSE;
+        self->rate = 0;
+        self->confidence = 0;
+        self->time_to_empty = 0;
+        self->time_to_full = 0;
+        mce_battery_estimator_notify(self);
+    }
+}
+
+static
+void
+mce_battery_estimator_sample(
+    MceBatteryEstimator* self,
+    guint level,
+    gint64 time)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+    const gint64 dt = time - priv->time;
+
+    if (dt > 0) {
+        const double alpha = MCE_BATTERY_ESTIMATOR_ALPHA;
+        const double sample = ((double)level - (double)priv->level) *
+            MCE_BATTERY_ESTIMATOR_HOUR / dt;
+        double rate, spread;
+
+        priv->decay *= 1 - alpha;
+        if (priv->samples++) {
+            const double diff = sample - self->rate;
+
+            rate = self->rate + alpha * diff;
+            priv->variance = (1 - alpha) *
+                (priv->variance + alpha * diff * diff);
+        } else {
+            rate = sample;
+        }
+
+        /* Grows with the number of samples, drops with the noise */
+        spread = sqrt(priv->variance);
+        self->confidence = (1 - priv->decay) *
+            ((rate != 0) ? (fabs(rate) / (fabs(rate) + spread)) : 0);
+        self->rate = rate;
+        self->time_to_empty = (rate < 0) ?
+            (guint)(level * 3600.0 / -rate) : 0;
+        self->time_to_full = (rate > 0 && level < 100) ?
+            (guint)((100 - level) * 3600.0 / rate) : 0;
+        self->valid = TRUE;
+        GDEBUG("Battery rate %.2f%%/h (%.2f)", rate, self->confidence);
+        mce_battery_estimator_notify(self);
+    }
+}
+
+static
+void
+mce_battery_estimator_battery_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    MceBatteryEstimator* self = MCE_BATTERY_ESTIMATOR(arg);
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    if (!battery->valid) {
+        priv->level_known = FALSE;
+        mce_battery_estimator_reset(self);
+    } else if (!priv->level_known) {
+        /* The initial level, not a change */
+        priv->level_known = TRUE;
+        priv->level = battery->level;
+    } else if (priv->level != battery->level) {
+        /*
+         * Only the time between two level changes is meaningful,
+         * the first change after the reset is just the baseline.
+         */
+        if (priv->have_baseline) {
+            mce_battery_estimator_sample(self, battery->level,
+                battery->level_stamp.time);
+        }
+        priv->have_baseline = TRUE;
+        priv->level = battery->level;
+        priv->time = battery->level_stamp.time;
+    }
+}
+
+static
+void
+mce_battery_estimator_charger_changed(
+    MceCharger* charger,
+    void* arg)
+{
+    MceBatteryEstimator* self = MCE_BATTERY_ESTIMATOR(arg);
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    if (charger->valid) {
+        if (priv->charger_known && priv->charger_state != charger->state) {
+            /* The rate is about to change, start over */
+            GDEBUG("Charger state changed, resetting the estimate");
+            mce_battery_estimator_reset(self);
+        }
+        priv->charger_known = TRUE;
+        priv->charger_state = charger->state;
+    } else {
+        priv->charger_known = FALSE;
+    }
+}
+
+static
+void
+mce_battery_estimator_start(
+    MceBatteryEstimator* self)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    priv->battery_id[0] = mce_battery_add_valid_changed_handler(
+        priv->battery, mce_battery_estimator_battery_changed, self);
+    priv->battery_id[1] = mce_battery_add_level_changed_handler(
+        priv->battery, mce_battery_estimator_battery_changed, self);
+    priv->charger_id[0] = mce_charger_add_valid_changed_handler(
+        priv->charger, mce_battery_estimator_charger_changed, self);
+    priv->charger_id[1] = mce_charger_add_state_changed_handler(
+        priv->charger, mce_battery_estimator_charger_changed, self);
+    mce_battery_estimator_charger_changed(priv->charger, self);
+    mce_battery_estimator_battery_changed(priv->battery, self);
+}
+
+static
+void
+mce_battery_estimator_stop(
+    MceBatteryEstimator* self)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    mce_battery_remove_all_handlers(priv->battery, priv->battery_id);
+    mce_charger_remove_all_handlers(priv->charger, priv->charger_id);
+    if (priv->notify_timer) {
+        g_source_destroy(priv->notify_timer);
+        g_source_unref(priv->notify_timer);
+        priv->notify_timer = NULL;
+    }
+    priv->charger_known = FALSE;
+    priv->level_known = FALSE;
+    priv->have_baseline = FALSE;
+    priv->samples = 0;
+    priv->decay = 1;
+    priv->variance = 0;
+    self->valid = FALSE;
+    self->rate = 0;
+    self->confidence = 0;
+    self->time_to_empty = 0;
+    self->time_to_full = 0;
+}
+
+static
+void
+mce_battery_estimator_update_demand(
+    MceBatteryEstimator* self)
+{
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    if (g_signal_has_handler_pending(self,
+        mce_battery_estimator_signals[SIGNAL_CHANGED], 0, TRUE)) {
+        if (!priv->battery_id[0]) {
+            /* The first handler has been connected, start tracking */
+            mce_battery_estimator_start(self);
+        }
+    } else if (priv->battery_id[0]) {
+        /* Nobody is listening, stop tracking (and forget everything) */
+        mce_battery_estimator_stop(self);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceBatteryEstimator*
+mce_battery_estimator_new()
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceBatteryEstimator* self = mce_battery_estimator_new_for_proxy(proxy);
+
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceBatteryEstimator*
+mce_battery_estimator_new_for_proxy(
+    MceProxy* proxy)
+{
+    MceBatteryEstimator* self = NULL;
+
+    if (G_LIKELY(proxy)) {
+        mce_proxy_lock(proxy);
+        self = mce_proxy_object_ref(proxy,
+            MCE_PROXY_OBJECT_BATTERY_ESTIMATOR);
+        if (!self) {
+            MceBatteryEstimatorPriv* priv;
+
+            self = g_object_new(MCE_BATTERY_ESTIMATOR_TYPE, NULL);
+            priv = self->priv;
+            priv->proxy = mce_proxy_ref(proxy);
+            priv->battery = mce_battery_new_for_proxy(proxy);
+            priv->charger = mce_charger_new_for_proxy(proxy);
+            mce_proxy_object_set(proxy, MCE_PROXY_OBJECT_BATTERY_ESTIMATOR,
+                self);
+        }
+        mce_proxy_unlock(proxy);
+    }
+    return self;
+}
+
+MceBatteryEstimator*
+mce_battery_estimator_ref(
+    MceBatteryEstimator* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_BATTERY_ESTIMATOR(self));
+    }
+    return self;
+}
+
+void
+mce_battery_estimator_unref(
+    MceBatteryEstimator* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_unref(MCE_BATTERY_ESTIMATOR(self));
+    }
+}
+
+gulong
+mce_battery_estimator_add_changed_handler(
+    MceBatteryEstimator* self,
+    MceBatteryEstimatorFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = g_signal_connect(self, SIGNAL_CHANGED_NAME, G_CALLBACK(fn), arg);
+        mce_battery_estimator_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
+    }
+    return 0;
+}
+
+void
+mce_battery_estimator_remove_handler(
+    MceBatteryEstimator* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        g_signal_handler_disconnect(self, id);
+        mce_battery_estimator_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_battery_estimator_set_min_interval(
+    MceBatteryEstimator* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        /* Takes effect with the next notification */
+        mce_proxy_lock(proxy);
+        self->priv->min_interval_ms = ms;
+        mce_proxy_unlock(proxy);
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_battery_estimator_init(
+    MceBatteryEstimator* self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE(self,
+        MCE_BATTERY_ESTIMATOR_TYPE, MceBatteryEstimatorPriv);
+    self->priv->decay = 1;
+}
+
+static
+void
+mce_battery_estimator_finalize(
+    GObject* object)
+{
+    MceBatteryEstimator* self = MCE_BATTERY_ESTIMATOR(object);
+    MceBatteryEstimatorPriv* priv = self->priv;
+
+    if (priv->battery_id[0]) {
+        mce_battery_estimator_stop(self);
+    }
+    mce_battery_unref(priv->battery);
+    mce_charger_unref(priv->charger);
+    mce_proxy_unref(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_battery_estimator_class_init(
+    MceBatteryEstimatorClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_battery_estimator_finalize;
+    g_type_class_add_private(klass, sizeof(MceBatteryEstimatorPriv));
+    mce_battery_estimator_signals[SIGNAL_CHANGED] =
+        g_signal_new(SIGNAL_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_callbacks_p.h"
+
+/*
+ * The id is (serial << MCE_CALLBACK_INDEX_BITS) | (index + 1), i.e.
+ * it's never zero. The serial is incremented every time the slot gets
+ * reused, so that a stale id doesn't remove somebody else's callback.
+ */
+#define MCE_CALLBACK_INDEX_BITS (16)
+#define MCE_CALLBACK_INDEX_MASK ((1 << MCE_CALLBACK_INDEX_BITS) - 1)
+#define MCE_CALLBACK_SERIAL_MASK (G_MAXUINT >> MCE_CALLBACK_INDEX_BITS)
+#define MCE_CALLBACK_MAX_COUNT MCE_CALLBACK_INDEX_MASK
+
+struct mce_callback {
+    GCallback fn;           /* NULL if the slot is free */
+    void* arg;
+    guint event;
+    guint from_mask;        /* Transition callbacks only */
+    guint to_mask;
+    guint serial;
+    guint next_free;        /* Next free slot plus one */
+};
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gulong
+mce_callbacks_add(
+    MceCallbacks* list,
+    guint event,
+    GCallback fn,
+    void* arg)
+{
+    guint i;
+    MceCallback* cb;
+
+    if (list->free_slot) {
+        i = list->free_slot - 1;
+        cb = list->slot + i;
+        list->free_slot = cb->next_free;
+    } else if (list->count < MCE_CALLBACK_MAX_COUNT) {
+        i = list->count++;
+        list->slot = g_renew(MceCallback, list->slot, list->count);
+        cb = list->slot + i;
+        cb->serial = 0;
+    } else {
+        return 0;
+    }
+    cb->fn = fn;
+    cb->arg = arg;
+    cb->event = event;
+    cb->from_mask = cb->to_mask = MCE_MASK_ANY;
+    cb->serial = (cb->serial + 1) & MCE_CALLBACK_SERIAL_MASK;
+    cb->next_free = 0;
+    list->active++;
+    return ((gulong)cb->serial << MCE_CALLBACK_INDEX_BITS) | (i + 1);
+}
+
+gulong
+mce_callbacks_add_transition(
+    MceCallbacks* list,
+    guint event,
+    guint from_mask,
+    guint to_mask,
+    GCallback fn,
+    void* arg)
+{
+    const gulong id = mce_callbacks_add(list, event, fn, arg);
+
+    if (id) {
+        MceCallback* cb = list->slot + ((id & MCE_CALLBACK_INDEX_MASK) - 1);
+
+        cb->from_mask = from_mask;
+        cb->to_mask = to_mask;
+    }
+    return id;
+}
+
+gboolean
+mce_callbacks_remove(
+    MceCallbacks* list,
+    gulong id)
+{
+    const guint i = (id & MCE_CALLBACK_INDEX_MASK) - 1;
+
+    if (i < list->count) {
+        MceCallback* cb = list->slot + i;
+
+        if (cb->fn && cb->serial == (id >> MCE_CALLBACK_INDEX_BITS)) {
+            cb->fn = NULL;
+            cb->arg = NULL;
+            cb->next_free = list->free_slot;
+            list->free_slot = i + 1;
+            list->active--;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gboolean
+mce_callbacks_has(
+    const MceCallbacks* list,
+    guint event)
+{
+    if (list->active) {
+        guint i;
+
+        for (i = 0; i < list->count; i++) {
+            const MceCallback* cb = list->slot + i;
+
+            if (cb->fn && cb->event == event) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+void
+mce_callbacks_emit(
+    MceCallbacks* list,
+    guint event,
+    gpointer object)
+{
+    if (list->active) {
+        const guint count = list->count;
+        guint i;
+
+        /*
+         * The array may get reallocated by the callbacks, hence
+         * list->slot has to be re-read on each iteration. Callbacks
+         * added during the emission only get invoked if they happen
+         * to take a free slot which hasn't been reached yet.
+         */
+        for (i = 0; i < count; i++) {
+            const MceCallback* cb = list->slot + i;
+
+            if (cb->fn && cb->event == event) {
+                ((MceCallbackFunc)cb->fn)(object, cb->arg);
+            }
+        }
+    }
+}
+
+void
+mce_callbacks_emit_transition(
+    MceCallbacks* list,
+    guint event,
+    gpointer object,
+    int from,
+    int to)
+{
+    if (list->active) {
+        const guint count = list->count;
+        const guint from_bit = MCE_MASK(from);
+        const guint to_bit = MCE_MASK(to);
+        guint i;
+
+        /* The filtering is done before anything gets invoked */
+        for (i = 0; i < count; i++) {
+            const MceCallback* cb = list->slot + i;
+
+            if (cb->fn && cb->event == event &&
+                (cb->from_mask & from_bit) && (cb->to_mask & to_bit)) {
+                ((MceTransitionFunc)cb->fn)(object, from, to, cb->arg);
+            }
+        }
+    }
+}
+
+void
+mce_callbacks_clear(
+    MceCallbacks* list)
+{
+    g_free(list->slot);
+    memset(list, 0, sizeof(*list));
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_CALLBACKS_PRIVATE_H
+#define MCE_CALLBACKS_PRIVATE_H
+
+#include "mce_types_p.h"
+
+#include <glib-object.h>
+
+/*
+ * A flat array of callbacks, a cheaper alternative to GSignal for the
+ * notifications which may fire often. No closures, no marshalling and
+ * no handler lookup by name. The id encodes the slot index, removal
+ * takes constant time. Callbacks may be added and removed while the
+ * list is being emitted. A zero-initialized structure is an empty
+ * list, there's no need to initialize it.
+ */
+
+typedef struct mce_callback MceCallback;
+
+typedef struct mce_callbacks {
+    MceCallback* slot;
+    guint count;            /* Slots allocated */
+    guint active;           /* Slots in use */
+    guint free_slot;        /* Index of the first free slot plus one */
+} MceCallbacks;
+
+typedef void
+(*MceCallbackFunc)(
+    gpointer object,
+    void* arg);
+
+/*
+ * Transition callbacks are only invoked for the changes matching
+ * both masks, see MCE_MASK()
+ */
+typedef void
+(*MceTransitionFunc)(
+    gpointer object,
+    int from,
+    int to,
+    void* arg);
+
+gulong
+mce_callbacks_add(
+    MceCallbacks* list,
+    guint event,
+    GCallback fn,
+    void* arg)
+    MCE_INTERNAL;
+
+gulong
+mce_callbacks_add_transition(
+    MceCallbacks* list,
+    guint event,
+    guint from_mask,
+    guint to_mask,
+    GCallback fn,
+    void* arg)
+    MCE_INTERNAL;
+
+gboolean
+mce_callbacks_remove(
+    MceCallbacks* list,
+    gulong id)
+    MCE_INTERNAL;
+
+gboolean
+mce_callbacks_has(
+    const MceCallbacks* list,
+    guint event)
+    MCE_INTERNAL;
+
+void
+mce_callbacks_emit(
+    MceCallbacks* list,
+    guint event,
+    gpointer object)
+    MCE_INTERNAL;
+
+void
+mce_callbacks_emit_transition(
+    MceCallbacks* list,
+    guint event,
+    gpointer object,
+    int from,
+    int to)
+    MCE_INTERNAL;
+
+void
+mce_callbacks_clear(
+    MceCallbacks* list)
+    MCE_INTERNAL;
+
+#endif /* MCE_CALLBACKS_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
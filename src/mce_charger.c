@@ -35,7 +35,12 @@
  */
 
 #include "mce_charger.h"
-#include "mce_proxy.h"
+#include "mce_callbacks_p.h"
+#include "mce_clock_p.h"
+#include "mce_context_p.h"
+#include "mce_history_p.h"
+#include "mce_proxy_p.h"
+#include "mce_wait_p.h"
 #include "mce_log_p.h"
 
 #include <mce/dbus-names.h>
@@ -43,14 +48,16 @@
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 struct mce_charger_priv {
     MceProxy* proxy;
+    MceCallbacks callbacks;
+    guint seq;              /* Last MceStamp sequence number */
+    MceHistory* history;
+    gboolean eager;         /* Always tracked, see mce_charger_new() */
+    guint pins;             /* Tracked regardless of the handlers */
     gulong proxy_valid_id;
     gulong charger_state_ind_id;
+    gboolean have_state;
 };
 
 enum mce_charger_signal {
@@ -59,11 +66,21 @@ enum mce_charger_signal {
     SIGNAL_COUNT
 };
 
+/* Not a signal, only used with the callbacks */
+#define EVENT_STATE_TRANSITION SIGNAL_COUNT
+
 #define SIGNAL_VALID_CHANGED_NAME   "mce-charger-valid-changed"
 #define SIGNAL_STATE_CHANGED_NAME   "mce-charger-state-changed"
 
 static guint mce_charger_signals[SIGNAL_COUNT] = { 0 };
 
+static const MCE_HISTORY_FIELD mce_charger_history_fields[] = {
+    MCE_HISTORY_CHARGER_VALID,
+    MCE_HISTORY_CHARGER_STATE
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_charger_history_fields) == SIGNAL_COUNT);
+
 typedef GObjectClass MceChargerClass;
 G_DEFINE_TYPE(MceCharger, mce_charger, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_charger_parent_class
@@ -75,6 +92,56 @@ G_DEFINE_TYPE(MceCharger, mce_charger, G_TYPE_OBJECT)
  * Implementation
  *==========================================================================*/
 
+static
+void
+mce_charger_emit(
+    MceCharger* self,
+    enum mce_charger_signal sig)
+{
+    MceChargerPriv* priv = self->priv;
+
+    if (priv->history) {
+        const MceStamp* stamp = NULL;
+        gint value = 0;
+
+        switch (sig) {
+        case SIGNAL_VALID_CHANGED:
+            value = self->valid;
+            /* Becoming valid is caused by a report, invalid is not */
+            if (self->valid) {
+                stamp = &self->state_stamp;
+            }
+            break;
+        case SIGNAL_STATE_CHANGED:
+            value = self->state;
+            stamp = &self->state_stamp;
+            break;
+        case SIGNAL_COUNT:
+            break;
+        }
+        mce_history_add(priv->history, mce_charger_history_fields[sig], value,
+            stamp, priv->seq);
+    }
+    g_signal_emit(self, mce_charger_signals[sig], 0);
+    mce_callbacks_emit(&priv->callbacks, sig, self);
+}
+
+static
+gboolean
+mce_charger_has_handlers(
+    MceCharger* self,
+    enum mce_charger_signal sig)
+{
+    const MceCallbacks* callbacks = &self->priv->callbacks;
+
+    /* Transition callbacks need the state to be tracked */
+    return (sig == SIGNAL_STATE_CHANGED &&
+        mce_callbacks_has(callbacks, EVENT_STATE_TRANSITION)) ||
+        mce_callbacks_has(callbacks, sig) ||
+        g_signal_has_handler_pending(self, mce_charger_signals[sig], 0,
+            TRUE);
+}
+
 static
 void
 mce_charger_state_update(
@@ -92,78 +159,114 @@ mce_charger_state_update(
         GASSERT(!g_strcmp0(value, MCE_CHARGER_STATE_UNKNOWN));
         state = MCE_CHARGER_UNKNOWN;
     }
+    priv->have_state = TRUE;
+    mce_residency_enter(mce_proxy_residency(priv->proxy,
+        MCE_PROXY_CHARGER_STATE), state, self->state_stamp.time);
     if (self->state != state) {
+        if (self->valid) {
+            mce_callbacks_emit_transition(&priv->callbacks,
+                EVENT_STATE_TRANSITION, self, self->state, state);
+        }
         self->state = state;
-        g_signal_emit(self, mce_charger_signals[SIGNAL_STATE_CHANGED], 0);
+        mce_charger_emit(self, SIGNAL_STATE_CHANGED);
     }
     if (priv->proxy->valid && !self->valid) {
         self->valid = TRUE;
-        g_signal_emit(self, mce_charger_signals[SIGNAL_VALID_CHANGED], 0);
+        mce_charger_emit(self, SIGNAL_VALID_CHANGED);
     }
 }
 
 static
 void
-mce_charger_state_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_charger_state_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
-    GError* error = NULL;
-    char* state = NULL;
     MceCharger* self = MCE_CHARGER(arg);
 
-    if (com_nokia_mce_request_call_get_charger_state_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &state, result, &error)) {
-        GDEBUG("Charger is currently %s", state);
-        mce_charger_state_update(self, state);
-        g_free(state);
-    } else {
-        /*
-         * We could retry but it's probably not worth the trouble
-         * because the next time charger state changes we receive
-         * charger_state_ind signal and sync our state with mce.
-         * Until then, this object stays invalid.
-         */
-        GWARN("Failed to query charger state %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_charger_unref(self);
+    GDEBUG("Charger is %s", value->str);
+    self->state_stamp.time = value->time;
+    self->state_stamp.seq = ++self->priv->seq;
+    mce_charger_state_update(self, value->str);
 }
 
 static
 void
-mce_charger_state_ind(
-    ComNokiaMceSignal* proxy,
-    const char* state,
-    gpointer arg)
+mce_charger_update_demand(
+    MceCharger* self)
 {
-    GDEBUG("Charger is %s", state);
-    mce_charger_state_update(MCE_CHARGER(arg), state);
+    MceChargerPriv* priv = self->priv;
+    gboolean demand = priv->eager || priv->pins;
+    int i;
+
+    for (i = 0; i < SIGNAL_COUNT && !demand; i++) {
+        demand = mce_charger_has_handlers(self, i);
+    }
+    if (demand) {
+        if (!priv->charger_state_ind_id) {
+            /* The first handler has been connected, start tracking */
+            priv->charger_state_ind_id =
+                mce_proxy_add_signal_handler(priv->proxy,
+                    MCE_PROXY_CHARGER_STATE, mce_charger_state_ind, self);
+        }
+    } else if (priv->charger_state_ind_id) {
+        /* Nobody is listening, stop tracking */
+        mce_proxy_remove_signal_handler(priv->proxy,
+            MCE_PROXY_CHARGER_STATE, priv->charger_state_ind_id);
+        priv->charger_state_ind_id = 0;
+        priv->have_state = FALSE;
+        if (self->valid) {
+            self->valid = FALSE;
+            mce_charger_emit(self, SIGNAL_VALID_CHANGED);
+        }
+    }
 }
 
 static
-void
-mce_charger_state_query(
-    MceCharger* self)
+gulong
+mce_charger_add_handler(
+    MceCharger* self,
+    const char* name,
+    MceChargerFunc fn,
+    void* arg,
+    gboolean in_context)
 {
-    MceChargerPriv* priv = self->priv;
-    MceProxy* proxy = priv->proxy;
-
-    /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceCharger is created. In that case we have to wait
-     * for the valid signal before we can connect the charger state
-     * signal and submit the initial query.
-     */
-    if (proxy->signal && !priv->charger_state_ind_id) {
-        priv->charger_state_ind_id = g_signal_connect(proxy->signal,
-            MCE_CHARGER_STATE_SIG, G_CALLBACK(mce_charger_state_ind), self);
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = in_context ?
+            mce_context_connect(self, name, G_CALLBACK(fn), arg) :
+            g_signal_connect(self, name, G_CALLBACK(fn), arg);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
-    if (proxy->request && proxy->valid) {
-        com_nokia_mce_request_call_get_charger_state(proxy->request, NULL,
-            mce_charger_state_query_done, mce_charger_ref(self));
+    return 0;
+}
+
+static
+gulong
+mce_charger_add_callback(
+    MceCharger* self,
+    enum mce_charger_signal sig,
+    MceChargerFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add(&self->priv->callbacks, sig, G_CALLBACK(fn),
+            arg);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
+    return 0;
 }
 
 static
@@ -175,15 +278,82 @@ mce_charger_valid_changed(
     MceCharger* self = MCE_CHARGER(arg);
 
     if (proxy->valid) {
-        mce_charger_state_query(self);
+        if (self->priv->have_state && !self->valid) {
+            /* The initial query has completed before the name appeared */
+            self->valid = TRUE;
+            mce_charger_emit(self, SIGNAL_VALID_CHANGED);
+        }
     } else {
+        self->priv->have_state = FALSE;
+        mce_residency_leave(mce_proxy_residency(self->priv->proxy,
+            MCE_PROXY_CHARGER_STATE), mce_clock_boottime());
         if (self->valid) {
             self->valid = FALSE;
-            g_signal_emit(self, mce_charger_signals[SIGNAL_VALID_CHANGED], 0);
+            mce_charger_emit(self, SIGNAL_VALID_CHANGED);
         }
     }
 }
 
+static
+void
+mce_charger_pin(
+    gpointer object)
+{
+    MceCharger* self = MCE_CHARGER(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    self->priv->pins++;
+    mce_charger_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+void
+mce_charger_unpin(
+    gpointer object)
+{
+    MceCharger* self = MCE_CHARGER(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    GASSERT(self->priv->pins);
+    self->priv->pins--;
+    mce_charger_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+MceCharger*
+mce_charger_create(
+    MceProxy* proxy,
+    gboolean eager)
+{
+    /* Eager and lazy objects don't share the state */
+    const MCE_PROXY_OBJECT type = eager ?
+        MCE_PROXY_OBJECT_CHARGER_EAGER :
+        MCE_PROXY_OBJECT_CHARGER;
+    MceCharger* self;
+
+    /* MCE assumes one charger */
+    mce_proxy_lock(proxy);
+    self = mce_proxy_object_ref(proxy, type);
+    if (!self) {
+        MceChargerPriv* priv;
+
+        self = g_object_new(MCE_CHARGER_TYPE, NULL);
+        priv = self->priv;
+        priv->proxy = mce_proxy_ref(proxy);
+        priv->eager = eager;
+        priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(proxy,
+            mce_charger_valid_changed, self);
+        mce_charger_update_demand(self);
+        mce_proxy_object_set(proxy, type, self);
+    }
+    mce_proxy_unlock(proxy);
+    return self;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -191,18 +361,30 @@ mce_charger_valid_changed(
 MceCharger*
 mce_charger_new()
 {
-    /* MCE assumes one charger */
-    static MceCharger* mce_charger_instance = NULL;
+    MceProxy* proxy = mce_proxy_new();
+    MceCharger* self = mce_charger_create(proxy, TRUE);
 
-    if (mce_charger_instance) {
-        mce_charger_ref(mce_charger_instance);
-    } else {
-        mce_charger_instance = g_object_new(MCE_CHARGER_TYPE, NULL);
-        mce_charger_state_query(mce_charger_instance);
-        g_object_add_weak_pointer(G_OBJECT(mce_charger_instance),
-            (gpointer*)(&mce_charger_instance));
-    }
-    return mce_charger_instance;
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceCharger*
+mce_charger_new_for_proxy(
+    MceProxy* proxy)
+{
+    return G_LIKELY(proxy) ? mce_charger_create(proxy, FALSE) : NULL;
+}
+
+MceCharger*
+mce_charger_new_sync(
+    guint timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceCharger* self = mce_charger_create(proxy, TRUE);
+
+    mce_proxy_sync(proxy, timeout_ms);
+    mce_proxy_unref(proxy);
+    return self;
 }
 
 MceCharger*
@@ -230,8 +412,18 @@ mce_charger_add_valid_changed_handler(
     MceChargerFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_charger_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_charger_add_valid_changed_handler_in_context(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return mce_charger_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -240,8 +432,18 @@ mce_charger_add_state_changed_handler(
     MceChargerFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_charger_add_handler(self, SIGNAL_STATE_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_charger_add_state_changed_handler_in_context(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return mce_charger_add_handler(self, SIGNAL_STATE_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 void
@@ -250,7 +452,12 @@ mce_charger_remove_handler(
     gulong id)
 {
     if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
         g_signal_handler_disconnect(self, id);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
     }
 }
 
@@ -260,7 +467,111 @@ mce_charger_remove_handlers(
     gulong* ids,
     guint count)
 {
-    gutil_disconnect_handlers(self, ids, count);
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        gutil_disconnect_handlers(self, ids, count);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_charger_add_valid_changed_callback(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return mce_charger_add_callback(self, SIGNAL_VALID_CHANGED, fn, arg);
+}
+
+gulong
+mce_charger_add_state_changed_callback(
+    MceCharger* self,
+    MceChargerFunc fn,
+    void* arg)
+{
+    return mce_charger_add_callback(self, SIGNAL_STATE_CHANGED, fn, arg);
+}
+
+gulong
+mce_charger_add_state_transition_callback(
+    MceCharger* self,
+    guint from_mask,
+    guint to_mask,
+    MceChargerTransitionFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add_transition(&self->priv->callbacks,
+            EVENT_STATE_TRANSITION, from_mask, to_mask, G_CALLBACK(fn), arg);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
+    }
+    return 0;
+}
+
+void
+mce_charger_remove_callback(
+    MceCharger* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        mce_callbacks_remove(&self->priv->callbacks, id);
+        mce_charger_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_charger_set_history(
+    MceCharger* self,
+    MceHistory* history)
+{
+    if (G_LIKELY(self)) {
+        MceChargerPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        if (priv->history != history) {
+            mce_history_unref(priv->history);
+            priv->history = mce_history_ref(history);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_charger_wait_valid_async(
+    MceCharger* self,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(self)) {
+        mce_wait_valid_async(self, SIGNAL_VALID_CHANGED_NAME, &self->valid,
+            mce_charger_pin, mce_charger_unpin, timeout_ms, cancellable,
+            callback, user_data);
+    }
+}
+
+gboolean
+mce_charger_wait_valid_finish(
+    MceCharger* self,
+    GAsyncResult* result,
+    GError** error)
+{
+    return mce_wait_valid_finish(self, result, error);
 }
 
 /*==========================================================================*
@@ -276,25 +587,38 @@ mce_charger_init(
         MceChargerPriv);
 
     self->priv = priv;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_charger_valid_changed, self);
 }
 
 static
 void
-mce_charger_finalize(
+mce_charger_dispose(
     GObject* object)
 {
     MceCharger* self = MCE_CHARGER(object);
     MceChargerPriv* priv = self->priv;
 
-    if (priv->charger_state_ind_id) {
-        g_signal_handler_disconnect(priv->proxy->signal,
-            priv->charger_state_ind_id);
-    }
+    /* Make sure that the proxy isn't about to call us */
+    mce_proxy_lock(priv->proxy);
+    mce_proxy_remove_signal_handler(priv->proxy, MCE_PROXY_CHARGER_STATE,
+        priv->charger_state_ind_id);
+    priv->charger_state_ind_id = 0;
     mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    priv->proxy_valid_id = 0;
+    mce_proxy_unlock(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
+}
+
+static
+void
+mce_charger_finalize(
+    GObject* object)
+{
+    MceCharger* self = MCE_CHARGER(object);
+    MceChargerPriv* priv = self->priv;
+
     mce_proxy_unref(priv->proxy);
+    mce_callbacks_clear(&priv->callbacks);
+    mce_history_unref(priv->history);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -305,6 +629,7 @@ mce_charger_class_init(
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
 
+    object_class->dispose = mce_charger_dispose;
     object_class->finalize = mce_charger_finalize;
     g_type_class_add_private(klass, sizeof(MceChargerPriv));
     mce_charger_signals[SIGNAL_VALID_CHANGED] =
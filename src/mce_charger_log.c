@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_charger_log.h"
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_clock_p.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+#define MCE_CHARGER_LOG_DEFAULT_GRACE_MS (30000)
+
+/* Everything is protected by the proxy lock */
+struct mce_charger_log {
+    MceProxy* proxy;
+    MceBattery* battery;
+    MceCharger* charger;
+    gulong battery_id[3];
+    gulong charger_id[2];
+    gint64 grace;           /* Microseconds */
+    gboolean charging;
+    guint capacity;
+    guint64 written;        /* Total number of sessions ever started */
+    MceChargerSession* sessions;
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MceChargerSession*
+mce_charger_log_last(
+    MceChargerLog* self)
+{
+    return self->written ?
+        (self->sessions + ((self->written - 1) % self->capacity)) : NULL;
+}
+
+static
+int
+mce_charger_log_level(
+    MceChargerLog* self)
+{
+    return self->battery->valid ? (int)self->battery->level : -1;
+}
+
+static
+void
+mce_charger_log_battery_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    MceChargerLog* self = arg;
+    MceChargerSession* last = mce_charger_log_last(self);
+
+    if (self->charging && last && battery->valid) {
+        last->end_level = battery->level;
+        if (last->start_level < 0) {
+            last->start_level = battery->level;
+        }
+        if (!last->time_to_full && battery->status == MCE_BATTERY_FULL) {
+            /* Non-zero even if it was full right from the start */
+            last->time_to_full = MAX(battery->status_stamp.time -
+                last->start, 1);
+        }
+    }
+}
+
+static
+void
+mce_charger_log_charger_changed(
+    MceCharger* charger,
+    void* arg)
+{
+    MceChargerLog* self = arg;
+    const gboolean charging = charger->valid &&
+        charger->state == MCE_CHARGER_ON;
+
+    if (self->charging != charging) {
+        MceChargerSession* last = mce_charger_log_last(self);
+        const gint64 time = charger->valid ? charger->state_stamp.time :
+            mce_clock_boottime();
+
+        self->charging = charging;
+        if (charging) {
+            if (last && last->end && time - last->end <= self->grace) {
+                /* Reconnected soon enough, same session */
+                GDEBUG("Charging resumed");
+                last->end = 0;
+                last->interruptions++;
+            } else {
+                GDEBUG("Charging session started");
+                last = self->sessions + (self->written++ % self->capacity);
+                memset(last, 0, sizeof(*last));
+                last->start = time;
+                last->start_level = last->end_level =
+                    mce_charger_log_level(self);
+                mce_charger_log_battery_changed(self->battery, self);
+            }
+        } else if (last) {
+            GDEBUG("Charging session ended");
+            last->end = time;
+            last->end_level = mce_charger_log_level(self);
+        }
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceChargerLog*
+mce_charger_log_new(
+    MceProxy* proxy,
+    guint capacity)
+{
+    if (G_LIKELY(proxy)) {
+        MceChargerLog* self = g_slice_new0(MceChargerLog);
+
+        self->proxy = mce_proxy_ref(proxy);
+        self->grace = ((gint64)MCE_CHARGER_LOG_DEFAULT_GRACE_MS) * 1000;
+        self->capacity = MAX(capacity, 1);
+        self->sessions = g_new0(MceChargerSession, self->capacity);
+        self->battery = mce_battery_new_for_proxy(proxy);
+        self->charger = mce_charger_new_for_proxy(proxy);
+
+        mce_proxy_lock(proxy);
+        self->battery_id[0] = mce_battery_add_valid_changed_handler(
+            self->battery, mce_charger_log_battery_changed, self);
+        self->battery_id[1] = mce_battery_add_level_changed_handler(
+            self->battery, mce_charger_log_battery_changed, self);
+        self->battery_id[2] = mce_battery_add_status_changed_handler(
+            self->battery, mce_charger_log_battery_changed, self);
+        self->charger_id[0] = mce_charger_add_valid_changed_handler(
+            self->charger, mce_charger_log_charger_changed, self);
+        self->charger_id[1] = mce_charger_add_state_changed_handler(
+            self->charger, mce_charger_log_charger_changed, self);
+        mce_charger_log_charger_changed(self->charger, self);
+        mce_proxy_unlock(proxy);
+        return self;
+    }
+    return NULL;
+}
+
+void
+mce_charger_log_free(
+    MceChargerLog* self)
+{
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->proxy;
+
+        /* The handlers are invoked under the same lock */
+        mce_proxy_lock(proxy);
+        mce_battery_remove_all_handlers(self->battery, self->battery_id);
+        mce_charger_remove_all_handlers(self->charger, self->charger_id);
+        mce_proxy_unlock(proxy);
+        mce_battery_unref(self->battery);
+        mce_charger_unref(self->charger);
+        mce_proxy_unref(self->proxy);
+        g_free(self->sessions);
+        g_slice_free(MceChargerLog, self);
+    }
+}
+
+void
+mce_charger_log_set_grace_period(
+    MceChargerLog* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->proxy;
+
+        mce_proxy_lock(proxy);
+        self->grace = ((gint64)ms) * 1000;
+        mce_proxy_unlock(proxy);
+    }
+}
+
+guint
+mce_charger_log_count(
+    MceChargerLog* self)
+{
+    guint count = 0;
+
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->proxy;
+
+        mce_proxy_lock(proxy);
+        count = (guint)MIN(self->written, self->capacity);
+        mce_proxy_unlock(proxy);
+    }
+    return count;
+}
+
+guint
+mce_charger_log_copy(
+    MceChargerLog* self,
+    MceChargerSession* sessions,
+    guint max)
+{
+    guint n = 0;
+
+    if (G_LIKELY(self) && G_LIKELY(sessions)) {
+        MceProxy* proxy = self->proxy;
+        guint64 pos;
+
+        mce_proxy_lock(proxy);
+        n = (guint)MIN(MIN(self->written, self->capacity), max);
+        for (pos = self->written - n; pos < self->written; pos++) {
+            *sessions++ = self->sessions[pos % self->capacity];
+        }
+        mce_proxy_unlock(proxy);
+    }
+    return n;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_condition.h"
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_tklock.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+/* Updated by the tracker handlers, under the proxy lock */
+typedef struct mce_condition_source {
+    GSource source;
+    MceConditionTerm* terms;
+    gboolean* met;
+    guint count;
+    guint unmet;
+    gboolean state;
+    gint ready;                 /* Accessed atomically */
+    MceBattery* battery;
+    MceCharger* charger;
+    MceDisplay* display;
+    MceTklock* tklock;
+    MceInactivity* inactivity;
+    gulong battery_id[3];
+    gulong charger_id[2];
+    gulong display_id[2];
+    gulong tklock_id[3];
+    gulong inactivity_id[2];
+} MceConditionSource;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+MCE_PROXY_OBJECT
+mce_condition_input_object(
+    MCE_CONDITION_INPUT input)
+{
+    switch (input) {
+    case MCE_CONDITION_BATTERY_LEVEL:
+    case MCE_CONDITION_BATTERY_STATUS:
+        return MCE_PROXY_OBJECT_BATTERY;
+    case MCE_CONDITION_CHARGER_STATE:
+        return MCE_PROXY_OBJECT_CHARGER;
+    case MCE_CONDITION_DISPLAY_STATE:
+        return MCE_PROXY_OBJECT_DISPLAY;
+    case MCE_CONDITION_TKLOCK_MODE:
+    case MCE_CONDITION_TKLOCK_LOCKED:
+        return MCE_PROXY_OBJECT_TKLOCK;
+    case MCE_CONDITION_INACTIVITY_STATUS:
+        return MCE_PROXY_OBJECT_INACTIVITY;
+    }
+    return MCE_PROXY_OBJECT_COUNT;
+}
+
+static
+gboolean
+mce_condition_input_value(
+    MceConditionSource* self,
+    MCE_CONDITION_INPUT input,
+    int* value)
+{
+    switch (input) {
+    case MCE_CONDITION_BATTERY_LEVEL:
+        *value = self->battery->level;
+        return self->battery->valid;
+    case MCE_CONDITION_BATTERY_STATUS:
+        *value = self->battery->status;
+        return self->battery->valid;
+    case MCE_CONDITION_CHARGER_STATE:
+        *value = self->charger->state;
+        return self->charger->valid;
+    case MCE_CONDITION_DISPLAY_STATE:
+        *value = self->display->state;
+        return self->display->valid;
+    case MCE_CONDITION_TKLOCK_MODE:
+        *value = self->tklock->mode;
+        return self->tklock->valid;
+    case MCE_CONDITION_TKLOCK_LOCKED:
+        *value = self->tklock->locked;
+        return self->tklock->valid;
+    case MCE_CONDITION_INACTIVITY_STATUS:
+        *value = self->inactivity->status;
+        return self->inactivity->valid;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+mce_condition_term_met(
+    MceConditionSource* self,
+    const MceConditionTerm* term)
+{
+    int value;
+
+    if (mce_condition_input_value(self, term->input, &value)) {
+        switch (term->op) {
+        case MCE_CONDITION_EQ: return value == term->value;
+        case MCE_CONDITION_NE: return value != term->value;
+        case MCE_CONDITION_LT: return value < term->value;
+        case MCE_CONDITION_LE: return value <= term->value;
+        case MCE_CONDITION_GT: return value > term->value;
+        case MCE_CONDITION_GE: return value >= term->value;
+        }
+    }
+    return FALSE;
+}
+
+static
+void
+mce_condition_update(
+    MceConditionSource* self,
+    MCE_PROXY_OBJECT object)
+{
+    guint i;
+    gboolean state;
+
+    /* Only the terms referring to this object may have changed */
+    for (i = 0; i < self->count; i++) {
+        const MceConditionTerm* term = self->terms + i;
+
+        if (mce_condition_input_object(term->input) == object) {
+            const gboolean met = mce_condition_term_met(self, term);
+
+            if (self->met[i] != met) {
+                self->met[i] = met;
+                if (met) {
+                    self->unmet--;
+                } else {
+                    self->unmet++;
+                }
+            }
+        }
+    }
+
+    state = !self->unmet;
+    if (self->state != state) {
+        self->state = state;
+        GDEBUG("Condition %p is %s", self, state ? "true" : "false");
+        if (!state) {
+            /* The edge is gone before it has been dispatched */
+            g_atomic_int_set(&self->ready, FALSE);
+        } else if (!g_source_is_destroyed(&self->source)) {
+            GMainContext* context = g_source_get_context(&self->source);
+
+            /* The update may come from another thread */
+            g_atomic_int_set(&self->ready, TRUE);
+            if (context) {
+                g_main_context_wakeup(context);
+            }
+        }
+    }
+}
+
+static
+void
+mce_condition_battery_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    mce_condition_update(arg, MCE_PROXY_OBJECT_BATTERY);
+}
+
+static
+void
+mce_condition_charger_changed(
+    MceCharger* charger,
+    void* arg)
+{
+    mce_condition_update(arg, MCE_PROXY_OBJECT_CHARGER);
+}
+
+static
+void
+mce_condition_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    mce_condition_update(arg, MCE_PROXY_OBJECT_DISPLAY);
+}
+
+static
+void
+mce_condition_tklock_changed(
+    MceTklock* tklock,
+    void* arg)
+{
+    mce_condition_update(arg, MCE_PROXY_OBJECT_TKLOCK);
+}
+
+static
+void
+mce_condition_inactivity_changed(
+    MceInactivity* inactivity,
+    void* arg)
+{
+    mce_condition_update(arg, MCE_PROXY_OBJECT_INACTIVITY);
+}
+
+static
+void
+mce_condition_track(
+    MceConditionSource* self,
+    MceProxy* proxy,
+    MCE_CONDITION_INPUT input)
+{
+    /* Connect only the signals which the terms actually depend on */
+    switch (input) {
+    case MCE_CONDITION_BATTERY_LEVEL:
+    case MCE_CONDITION_BATTERY_STATUS:
+        /*
+         * The level (or status) handler goes first, otherwise the
+         * valid handler would briefly subscribe to both of them.
+         */
+        if (!self->battery) {
+            self->battery = mce_battery_new_for_proxy(proxy);
+        }
+        if (input == MCE_CONDITION_BATTERY_LEVEL) {
+            if (!self->battery_id[1]) {
+                self->battery_id[1] = mce_battery_add_level_changed_handler(
+                    self->battery, mce_condition_battery_changed, self);
+            }
+        } else if (!self->battery_id[2]) {
+            self->battery_id[2] = mce_battery_add_status_changed_handler(
+                self->battery, mce_condition_battery_changed, self);
+        }
+        if (!self->battery_id[0]) {
+            self->battery_id[0] = mce_battery_add_valid_changed_handler(
+                self->battery, mce_condition_battery_changed, self);
+        }
+        break;
+    case MCE_CONDITION_CHARGER_STATE:
+        if (!self->charger) {
+            self->charger = mce_charger_new_for_proxy(proxy);
+            self->charger_id[0] = mce_charger_add_valid_changed_handler(
+                self->charger, mce_condition_charger_changed, self);
+            self->charger_id[1] = mce_charger_add_state_changed_handler(
+                self->charger, mce_condition_charger_changed, self);
+        }
+        break;
+    case MCE_CONDITION_DISPLAY_STATE:
+        if (!self->display) {
+            self->display = mce_display_new_for_proxy(proxy);
+            self->display_id[0] = mce_display_add_valid_changed_handler(
+                self->display, mce_condition_display_changed, self);
+            self->display_id[1] = mce_display_add_state_changed_handler(
+                self->display, mce_condition_display_changed, self);
+        }
+        break;
+    case MCE_CONDITION_TKLOCK_MODE:
+    case MCE_CONDITION_TKLOCK_LOCKED:
+        if (!self->tklock) {
+            self->tklock = mce_tklock_new_for_proxy(proxy);
+            self->tklock_id[0] = mce_tklock_add_valid_changed_handler(
+                self->tklock, mce_condition_tklock_changed, self);
+        }
+        if (input == MCE_CONDITION_TKLOCK_MODE) {
+            if (!self->tklock_id[1]) {
+                self->tklock_id[1] = mce_tklock_add_mode_changed_handler(
+                    self->tklock, mce_condition_tklock_changed, self);
+            }
+        } else if (!self->tklock_id[2]) {
+            self->tklock_id[2] = mce_tklock_add_locked_changed_handler(
+                self->tklock, mce_condition_tklock_changed, self);
+        }
+        break;
+    case MCE_CONDITION_INACTIVITY_STATUS:
+        if (!self->inactivity) {
+            self->inactivity = mce_inactivity_new_for_proxy(proxy);
+            self->inactivity_id[0] =
+                mce_inactivity_add_valid_changed_handler(self->inactivity,
+                    mce_condition_inactivity_changed, self);
+            self->inactivity_id[1] =
+                mce_inactivity_add_status_changed_handler(self->inactivity,
+                    mce_condition_inactivity_changed, self);
+        }
+        break;
+    }
+}
+
+static
+gboolean
+mce_condition_source_prepare(
+    GSource* source,
+    gint* timeout)
+{
+    *timeout = -1;
+    return g_atomic_int_get(&((MceConditionSource*)source)->ready);
+}
+
+static
+gboolean
+mce_condition_source_check(
+    GSource* source)
+{
+    return g_atomic_int_get(&((MceConditionSource*)source)->ready);
+}
+
+static
+gboolean
+mce_condition_source_dispatch(
+    GSource* source,
+    GSourceFunc callback,
+    gpointer user_data)
+{
+    MceConditionSource* self = (MceConditionSource*)source;
+
+    /* The predicate may have become false again since check() */
+    if (!g_atomic_int_compare_and_exchange(&self->ready, TRUE, FALSE)) {
+        return G_SOURCE_CONTINUE;
+    }
+    return callback ? callback(user_data) : G_SOURCE_CONTINUE;
+}
+
+static
+void
+mce_condition_source_finalize(
+    GSource* source)
+{
+    MceConditionSource* self = (MceConditionSource*)source;
+
+    if (self->battery) {
+        mce_battery_remove_all_handlers(self->battery, self->battery_id);
+        mce_battery_unref(self->battery);
+    }
+    if (self->charger) {
+        mce_charger_remove_all_handlers(self->charger, self->charger_id);
+        mce_charger_unref(self->charger);
+    }
+    if (self->display) {
+        mce_display_remove_all_handlers(self->display, self->display_id);
+        mce_display_unref(self->display);
+    }
+    if (self->tklock) {
+        mce_tklock_remove_all_handlers(self->tklock, self->tklock_id);
+        mce_tklock_unref(self->tklock);
+    }
+    if (self->inactivity) {
+        mce_inactivity_remove_all_handlers(self->inactivity,
+            self->inactivity_id);
+        mce_inactivity_unref(self->inactivity);
+    }
+    g_free(self->terms);
+    g_free(self->met);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+GSource*
+mce_condition_source_new(
+    MceProxy* proxy,
+    const MceConditionTerm* terms,
+    guint count)
+{
+    static GSourceFuncs mce_condition_source_funcs = {
+        mce_condition_source_prepare,
+        mce_condition_source_check,
+        mce_condition_source_dispatch,
+        mce_condition_source_finalize
+    };
+
+    if (G_LIKELY(proxy) && (G_LIKELY(terms) || !count)) {
+        GSource* source = g_source_new(&mce_condition_source_funcs,
+            sizeof(MceConditionSource));
+        MceConditionSource* self = (MceConditionSource*)source;
+        guint i;
+
+        g_source_set_name(source, "MceCondition");
+        self->terms = g_memdup(terms, sizeof(terms[0]) * count);
+        self->met = g_new0(gboolean, count);
+        self->count = self->unmet = count;
+
+        /* Handlers may fire on another thread as soon as connected */
+        mce_proxy_lock(proxy);
+        for (i = 0; i < count; i++) {
+            mce_condition_track(self, proxy, terms[i].input);
+        }
+        for (i = 0; i < MCE_PROXY_OBJECT_COUNT; i++) {
+            mce_condition_update(self, (MCE_PROXY_OBJECT)i);
+        }
+        mce_proxy_unlock(proxy);
+        return source;
+    }
+    return NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_context_p.h"
+
+typedef void
+(*MceContextFunc)(
+    GObject* object,
+    void* arg);
+
+typedef struct mce_context_handler {
+    gint ref_count;
+    gint connected;
+    GMainContext* context;
+    MceContextFunc fn;
+    void* arg;
+} MceContextHandler;
+
+typedef struct mce_context_call {
+    MceContextHandler* handler;
+    GObject* object;
+} MceContextCall;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_context_handler_unref(
+    MceContextHandler* handler)
+{
+    if (g_atomic_int_dec_and_test(&handler->ref_count)) {
+        g_main_context_unref(handler->context);
+        g_slice_free(MceContextHandler, handler);
+    }
+}
+
+static
+void
+mce_context_handler_disconnected(
+    gpointer data,
+    GClosure* closure)
+{
+    MceContextHandler* handler = data;
+
+    g_atomic_int_set(&handler->connected, FALSE);
+    mce_context_handler_unref(handler);
+}
+
+static
+gboolean
+mce_context_call_invoke(
+    gpointer data)
+{
+    MceContextCall* call = data;
+    MceContextHandler* handler = call->handler;
+
+    if (g_atomic_int_get(&handler->connected)) {
+        handler->fn(call->object, handler->arg);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_context_call_free(
+    gpointer data)
+{
+    MceContextCall* call = data;
+
+    g_object_unref(call->object);
+    mce_context_handler_unref(call->handler);
+    g_slice_free(MceContextCall, call);
+}
+
+static
+void
+mce_context_handler_emitted(
+    GObject* object,
+    gpointer data)
+{
+    MceContextHandler* handler = data;
+
+    if (g_main_context_is_owner(handler->context)) {
+        /* We are already there */
+        handler->fn(object, handler->arg);
+    } else {
+        MceContextCall* call = g_slice_new(MceContextCall);
+        GSource* source = g_idle_source_new();
+
+        call->handler = handler;
+        call->object = g_object_ref(object);
+        g_atomic_int_inc(&handler->ref_count);
+        g_source_set_callback(source, mce_context_call_invoke, call,
+            mce_context_call_free);
+        g_source_attach(source, handler->context);
+        g_source_unref(source);
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gulong
+mce_context_connect(
+    gpointer object,
+    const char* signal_name,
+    GCallback fn,
+    void* arg)
+{
+    MceContextHandler* handler = g_slice_new(MceContextHandler);
+
+    handler->ref_count = 1;
+    handler->connected = TRUE;
+    handler->context = g_main_context_ref_thread_default();
+    handler->fn = (MceContextFunc)fn;
+    handler->arg = arg;
+    return g_signal_connect_data(object, signal_name,
+        G_CALLBACK(mce_context_handler_emitted), handler,
+        mce_context_handler_disconnected, 0);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
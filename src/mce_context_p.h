@@ -1,6 +1,6 @@
 /*
- * Copyright (C) 2016-2022 Jolla Ltd.
- * Copyright (C) 2016-2022 Slava Monich <slava.monich@jolla.com>
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
  *
  * You may use this file under the terms of BSD license as follows:
  *
@@ -34,59 +34,30 @@
  * any official policies, either expressed or implied.
  */
 
-#ifndef MCE_PROXY_H
-#define MCE_PROXY_H
+#ifndef MCE_CONTEXT_PRIVATE_H
+#define MCE_CONTEXT_PRIVATE_H
 
 #include "mce_types_p.h"
 
 #include <glib-object.h>
 
-typedef struct mce_proxy_priv MceProxyPriv;
-struct _ComNokiaMceSignal;
-struct _ComNokiaMceRequest;
-
-typedef struct mce_proxy {
-    GObject object;
-    MceProxyPriv* priv;
-    gboolean valid;
-    struct _ComNokiaMceSignal* signal;
-    struct _ComNokiaMceRequest* request;
-} MceProxy;
-
-typedef void
-(*MceProxyFunc)(
-    MceProxy* proxy,
-    void* arg);
-
-MceProxy*
-mce_proxy_new(
-    void)
-    MCE_INTERNAL;
-
-MceProxy*
-mce_proxy_ref(
-    MceProxy* proxy)
-    MCE_INTERNAL;
-
-void
-mce_proxy_unref(
-    MceProxy* proxy)
-    MCE_INTERNAL;
-
+/*
+ * Connects a handler which gets invoked in the thread-default context
+ * of the calling thread, no matter which thread emits the signal. The
+ * callback is expected to have (GObject* object, void* arg) signature.
+ * The handler is disconnected with g_signal_handler_disconnect() as
+ * usual. If that happens on a thread other than the one the handler
+ * is delivered to, one pending invocation may still go through.
+ */
 gulong
-mce_proxy_add_valid_changed_handler(
-    MceProxy* proxy,
-    MceProxyFunc fn,
+mce_context_connect(
+    gpointer object,
+    const char* signal_name,
+    GCallback fn,
     void* arg)
     MCE_INTERNAL;
 
-void
-mce_proxy_remove_handler(
-    MceProxy* proxy,
-    gulong id)
-    MCE_INTERNAL;
-
-#endif /* MCE_PROXY_H */
+#endif /* MCE_CONTEXT_PRIVATE_H */
 
 /*
  * Local Variables:
@@ -35,7 +35,12 @@
  */
 
 #include "mce_display.h"
-#include "mce_proxy.h"
+#include "mce_callbacks_p.h"
+#include "mce_clock_p.h"
+#include "mce_context_p.h"
+#include "mce_history_p.h"
+#include "mce_proxy_p.h"
+#include "mce_wait_p.h"
 #include "mce_log_p.h"
 
 #include <mce/dbus-names.h>
@@ -43,14 +48,21 @@
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 struct mce_display_priv {
     MceProxy* proxy;
+    MceCallbacks callbacks;
+    guint seq;              /* Last MceStamp sequence number */
+    MceHistory* history;
+    gboolean eager;         /* Always tracked, see mce_display_new() */
+    guint pins;             /* Tracked regardless of the handlers */
     gulong proxy_valid_id;
     gulong display_status_ind_id;
+    gboolean have_status;
+    guint coalesce_ms;
+    GSource* coalesce_timer;
+    MCE_DISPLAY_STATE pending_state;
+    guint pending_transitions;
+    guint suppressed;
 };
 
 enum mce_display_signal {
@@ -59,11 +71,21 @@ enum mce_display_signal {
     SIGNAL_COUNT
 };
 
+/* Not a signal, only used with the callbacks */
+#define EVENT_STATE_TRANSITION SIGNAL_COUNT
+
 #define SIGNAL_VALID_CHANGED_NAME   "mce-display-valid-changed"
 #define SIGNAL_STATE_CHANGED_NAME   "mce-display-state-changed"
 
 static guint mce_display_signals[SIGNAL_COUNT] = { 0 };
 
+static const MCE_HISTORY_FIELD mce_display_history_fields[] = {
+    MCE_HISTORY_DISPLAY_VALID,
+    MCE_HISTORY_DISPLAY_STATE
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_display_history_fields) == SIGNAL_COUNT);
+
 typedef GObjectClass MceDisplayClass;
 G_DEFINE_TYPE(MceDisplay, mce_display, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_display_parent_class
@@ -75,6 +97,108 @@ G_DEFINE_TYPE(MceDisplay, mce_display, G_TYPE_OBJECT)
  * Implementation
  *==========================================================================*/
 
+static
+void
+mce_display_emit(
+    MceDisplay* self,
+    enum mce_display_signal sig)
+{
+    MceDisplayPriv* priv = self->priv;
+
+    if (priv->history) {
+        const MceStamp* stamp = NULL;
+        gint value = 0;
+
+        switch (sig) {
+        case SIGNAL_VALID_CHANGED:
+            value = self->valid;
+            /* Becoming valid is caused by a report, invalid is not */
+            if (self->valid) {
+                stamp = &self->state_stamp;
+            }
+            break;
+        case SIGNAL_STATE_CHANGED:
+            value = self->state;
+            stamp = &self->state_stamp;
+            break;
+        case SIGNAL_COUNT:
+            break;
+        }
+        mce_history_add(priv->history, mce_display_history_fields[sig], value,
+            stamp, priv->seq);
+    }
+    g_signal_emit(self, mce_display_signals[sig], 0);
+    mce_callbacks_emit(&priv->callbacks, sig, self);
+}
+
+static
+gboolean
+mce_display_has_handlers(
+    MceDisplay* self,
+    enum mce_display_signal sig)
+{
+    const MceCallbacks* callbacks = &self->priv->callbacks;
+
+    /* Transition callbacks need the state to be tracked */
+    return (sig == SIGNAL_STATE_CHANGED &&
+        mce_callbacks_has(callbacks, EVENT_STATE_TRANSITION)) ||
+        mce_callbacks_has(callbacks, sig) ||
+        g_signal_has_handler_pending(self, mce_display_signals[sig], 0,
+            TRUE);
+}
+
+static
+void
+mce_display_coalesce_cancel(
+    MceDisplay* self)
+{
+    MceDisplayPriv* priv = self->priv;
+
+    if (priv->coalesce_timer) {
+        g_source_destroy(priv->coalesce_timer);
+        g_source_unref(priv->coalesce_timer);
+        priv->coalesce_timer = NULL;
+    }
+    priv->pending_transitions = 0;
+}
+
+static
+void
+mce_display_coalesce_flush(
+    MceDisplay* self)
+{
+    MceDisplayPriv* priv = self->priv;
+    const guint transitions = priv->pending_transitions;
+
+    mce_display_coalesce_cancel(self);
+    if (transitions) {
+        /* Everything but the last change gets swallowed */
+        const gboolean changed = (self->state != priv->pending_state);
+
+        priv->suppressed += transitions - (changed ? 1 : 0);
+        if (changed) {
+            self->state = priv->pending_state;
+            mce_display_emit(self, SIGNAL_STATE_CHANGED);
+        }
+    }
+}
+
+static
+gboolean
+mce_display_coalesce_timeout(
+    gpointer data)
+{
+    MceDisplay* self = MCE_DISPLAY(data);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    g_source_unref(self->priv->coalesce_timer);
+    self->priv->coalesce_timer = NULL;
+    mce_display_coalesce_flush(self);
+    mce_proxy_unlock(proxy);
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 mce_display_status_update(
@@ -92,78 +216,134 @@ mce_display_status_update(
         GASSERT(!g_strcmp0(status, MCE_DISPLAY_ON_STRING));
         state = MCE_DISPLAY_STATE_ON;
     }
-    if (self->state != state) {
+    priv->have_status = TRUE;
+    mce_residency_enter(mce_proxy_residency(priv->proxy,
+        MCE_PROXY_DISPLAY_STATUS), state, self->state_stamp.time);
+    if (self->valid && priv->coalesce_ms) {
+        const MCE_DISPLAY_STATE last = priv->pending_transitions ?
+            priv->pending_state : self->state;
+
+        /* The state gets reported when the window closes */
+        if (state != last) {
+            mce_callbacks_emit_transition(&priv->callbacks,
+                EVENT_STATE_TRANSITION, self, last, state);
+            priv->pending_state = state;
+            priv->pending_transitions++;
+            if (!priv->coalesce_timer) {
+                priv->coalesce_timer = g_timeout_source_new(priv->coalesce_ms);
+                g_source_set_callback(priv->coalesce_timer,
+                    mce_display_coalesce_timeout, mce_display_ref(self),
+                    g_object_unref);
+                g_source_attach(priv->coalesce_timer,
+                    mce_proxy_context(priv->proxy));
+            }
+        }
+    } else if (self->state != state) {
+        if (self->valid) {
+            mce_callbacks_emit_transition(&priv->callbacks,
+                EVENT_STATE_TRANSITION, self, self->state, state);
+        }
         self->state = state;
-        g_signal_emit(self, mce_display_signals[SIGNAL_STATE_CHANGED], 0);
+        mce_display_emit(self, SIGNAL_STATE_CHANGED);
     }
     if (priv->proxy->valid && !self->valid) {
         self->valid = TRUE;
-        g_signal_emit(self, mce_display_signals[SIGNAL_VALID_CHANGED], 0);
+        mce_display_emit(self, SIGNAL_VALID_CHANGED);
     }
 }
 
 static
 void
-mce_display_status_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_display_status_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
-    GError* error = NULL;
-    char* status = NULL;
     MceDisplay* self = MCE_DISPLAY(arg);
 
-    if (com_nokia_mce_request_call_get_display_status_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &status, result, &error)) {
-        GDEBUG("Display is currently %s", status);
-        mce_display_status_update(self, status);
-        g_free(status);
-    } else {
-        /*
-         * We could retry but it's probably not worth the trouble
-         * because the next time display state changes we receive
-         * display_status_ind signal and sync our state with mce.
-         * Until then, this object stays invalid.
-         */
-        GWARN("Failed to query display state %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_display_unref(self);
+    GDEBUG("Display is %s", value->str);
+    self->state_stamp.time = value->time;
+    self->state_stamp.seq = ++self->priv->seq;
+    mce_display_status_update(self, value->str);
 }
 
 static
 void
-mce_display_status_ind(
-    ComNokiaMceSignal* proxy,
-    const char* status,
-    gpointer arg)
+mce_display_update_demand(
+    MceDisplay* self)
 {
-    GDEBUG("Display is %s", status);
-    mce_display_status_update(MCE_DISPLAY(arg), status);
+    MceDisplayPriv* priv = self->priv;
+    gboolean demand = priv->eager || priv->pins;
+    int i;
+
+    for (i = 0; i < SIGNAL_COUNT && !demand; i++) {
+        demand = mce_display_has_handlers(self, i);
+    }
+    if (demand) {
+        if (!priv->display_status_ind_id) {
+            /* The first handler has been connected, start tracking */
+            priv->display_status_ind_id =
+                mce_proxy_add_signal_handler(priv->proxy,
+                    MCE_PROXY_DISPLAY_STATUS, mce_display_status_ind, self);
+        }
+    } else if (priv->display_status_ind_id) {
+        /* Nobody is listening, stop tracking */
+        mce_proxy_remove_signal_handler(priv->proxy,
+            MCE_PROXY_DISPLAY_STATUS, priv->display_status_ind_id);
+        priv->display_status_ind_id = 0;
+        priv->have_status = FALSE;
+        mce_display_coalesce_cancel(self);
+        if (self->valid) {
+            self->valid = FALSE;
+            mce_display_emit(self, SIGNAL_VALID_CHANGED);
+        }
+    }
 }
 
 static
-void
-mce_display_status_query(
-    MceDisplay* self)
+gulong
+mce_display_add_handler(
+    MceDisplay* self,
+    const char* name,
+    MceDisplayFunc fn,
+    void* arg,
+    gboolean in_context)
 {
-    MceDisplayPriv* priv = self->priv;
-    MceProxy* proxy = priv->proxy;
-
-    /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceDisplay is created. In that case we have to wait
-     * for the valid signal before we can connect the display state
-     * signal and submit the initial query.
-     */
-    if (proxy->signal && !priv->display_status_ind_id) {
-        priv->display_status_ind_id = g_signal_connect(proxy->signal,
-            MCE_DISPLAY_SIG, G_CALLBACK(mce_display_status_ind), self);
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = in_context ?
+            mce_context_connect(self, name, G_CALLBACK(fn), arg) :
+            g_signal_connect(self, name, G_CALLBACK(fn), arg);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
-    if (proxy->request && proxy->valid) {
-        com_nokia_mce_request_call_get_display_status(proxy->request, NULL,
-            mce_display_status_query_done, mce_display_ref(self));
+    return 0;
+}
+
+static
+gulong
+mce_display_add_callback(
+    MceDisplay* self,
+    enum mce_display_signal sig,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add(&self->priv->callbacks, sig, G_CALLBACK(fn),
+            arg);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
+    return 0;
 }
 
 static
@@ -175,15 +355,83 @@ mce_display_valid_changed(
     MceDisplay* self = MCE_DISPLAY(arg);
 
     if (proxy->valid) {
-        mce_display_status_query(self);
+        if (self->priv->have_status && !self->valid) {
+            /* The initial query has completed before the name appeared */
+            self->valid = TRUE;
+            mce_display_emit(self, SIGNAL_VALID_CHANGED);
+        }
     } else {
+        self->priv->have_status = FALSE;
+        mce_residency_leave(mce_proxy_residency(self->priv->proxy,
+            MCE_PROXY_DISPLAY_STATUS), mce_clock_boottime());
+        mce_display_coalesce_cancel(self);
         if (self->valid) {
             self->valid = FALSE;
-            g_signal_emit(self, mce_display_signals[SIGNAL_VALID_CHANGED], 0);
+            mce_display_emit(self, SIGNAL_VALID_CHANGED);
         }
     }
 }
 
+static
+void
+mce_display_pin(
+    gpointer object)
+{
+    MceDisplay* self = MCE_DISPLAY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    self->priv->pins++;
+    mce_display_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+void
+mce_display_unpin(
+    gpointer object)
+{
+    MceDisplay* self = MCE_DISPLAY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    GASSERT(self->priv->pins);
+    self->priv->pins--;
+    mce_display_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+MceDisplay*
+mce_display_create(
+    MceProxy* proxy,
+    gboolean eager)
+{
+    /* Eager and lazy objects don't share the state */
+    const MCE_PROXY_OBJECT type = eager ?
+        MCE_PROXY_OBJECT_DISPLAY_EAGER :
+        MCE_PROXY_OBJECT_DISPLAY;
+    MceDisplay* self;
+
+    /* MCE assumes one display */
+    mce_proxy_lock(proxy);
+    self = mce_proxy_object_ref(proxy, type);
+    if (!self) {
+        MceDisplayPriv* priv;
+
+        self = g_object_new(MCE_DISPLAY_TYPE, NULL);
+        priv = self->priv;
+        priv->proxy = mce_proxy_ref(proxy);
+        priv->eager = eager;
+        priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(proxy,
+            mce_display_valid_changed, self);
+        mce_display_update_demand(self);
+        mce_proxy_object_set(proxy, type, self);
+    }
+    mce_proxy_unlock(proxy);
+    return self;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -191,18 +439,30 @@ mce_display_valid_changed(
 MceDisplay*
 mce_display_new()
 {
-    /* MCE assumes one display */
-    static MceDisplay* mce_display_instance = NULL;
+    MceProxy* proxy = mce_proxy_new();
+    MceDisplay* self = mce_display_create(proxy, TRUE);
 
-    if (mce_display_instance) {
-        mce_display_ref(mce_display_instance);
-    } else {
-        mce_display_instance = g_object_new(MCE_DISPLAY_TYPE, NULL);
-        mce_display_status_query(mce_display_instance);
-        g_object_add_weak_pointer(G_OBJECT(mce_display_instance),
-            (gpointer*)(&mce_display_instance));
-    }
-    return mce_display_instance;
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceDisplay*
+mce_display_new_for_proxy(
+    MceProxy* proxy)
+{
+    return G_LIKELY(proxy) ? mce_display_create(proxy, FALSE) : NULL;
+}
+
+MceDisplay*
+mce_display_new_sync(
+    guint timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceDisplay* self = mce_display_create(proxy, TRUE);
+
+    mce_proxy_sync(proxy, timeout_ms);
+    mce_proxy_unref(proxy);
+    return self;
 }
 
 MceDisplay*
@@ -230,8 +490,18 @@ mce_display_add_valid_changed_handler(
     MceDisplayFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_display_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_display_add_valid_changed_handler_in_context(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return mce_display_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -240,8 +510,18 @@ mce_display_add_state_changed_handler(
     MceDisplayFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_STATE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_display_add_handler(self, SIGNAL_STATE_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_display_add_state_changed_handler_in_context(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return mce_display_add_handler(self, SIGNAL_STATE_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 void
@@ -250,7 +530,12 @@ mce_display_remove_handler(
     gulong id)
 {
     if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
         g_signal_handler_disconnect(self, id);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
     }
 }
 
@@ -260,7 +545,145 @@ mce_display_remove_handlers(
     gulong* ids,
     guint count)
 {
-    gutil_disconnect_handlers(self, ids, count);
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        gutil_disconnect_handlers(self, ids, count);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_display_add_valid_changed_callback(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return mce_display_add_callback(self, SIGNAL_VALID_CHANGED, fn, arg);
+}
+
+gulong
+mce_display_add_state_changed_callback(
+    MceDisplay* self,
+    MceDisplayFunc fn,
+    void* arg)
+{
+    return mce_display_add_callback(self, SIGNAL_STATE_CHANGED, fn, arg);
+}
+
+gulong
+mce_display_add_state_transition_callback(
+    MceDisplay* self,
+    guint from_mask,
+    guint to_mask,
+    MceDisplayTransitionFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add_transition(&self->priv->callbacks,
+            EVENT_STATE_TRANSITION, from_mask, to_mask, G_CALLBACK(fn), arg);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
+    }
+    return 0;
+}
+
+void
+mce_display_remove_callback(
+    MceDisplay* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        mce_callbacks_remove(&self->priv->callbacks, id);
+        mce_display_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_display_set_coalesce_window(
+    MceDisplay* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        MceDisplayPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        priv->coalesce_ms = ms;
+        if (!ms) {
+            mce_display_coalesce_flush(self);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+guint
+mce_display_get_suppressed_count(
+    MceDisplay* self)
+{
+    guint count = 0;
+
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        count = self->priv->suppressed;
+        mce_proxy_unlock(proxy);
+    }
+    return count;
+}
+
+void
+mce_display_set_history(
+    MceDisplay* self,
+    MceHistory* history)
+{
+    if (G_LIKELY(self)) {
+        MceDisplayPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        if (priv->history != history) {
+            mce_history_unref(priv->history);
+            priv->history = mce_history_ref(history);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_display_wait_valid_async(
+    MceDisplay* self,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(self)) {
+        mce_wait_valid_async(self, SIGNAL_VALID_CHANGED_NAME, &self->valid,
+            mce_display_pin, mce_display_unpin, timeout_ms, cancellable,
+            callback, user_data);
+    }
+}
+
+gboolean
+mce_display_wait_valid_finish(
+    MceDisplay* self,
+    GAsyncResult* result,
+    GError** error)
+{
+    return mce_wait_valid_finish(self, result, error);
 }
 
 /*==========================================================================*
@@ -276,25 +699,43 @@ mce_display_init(
         MceDisplayPriv);
 
     self->priv = priv;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_display_valid_changed, self);
 }
 
 static
 void
-mce_display_finalize(
+mce_display_dispose(
     GObject* object)
 {
     MceDisplay* self = MCE_DISPLAY(object);
     MceDisplayPriv* priv = self->priv;
 
-    if (priv->display_status_ind_id) {
-        g_signal_handler_disconnect(priv->proxy->signal,
-            priv->display_status_ind_id);
-    }
+    /*
+     * The proxy invokes the handlers under its lock. Once they are
+     * removed, none of them is running and none will run, which must
+     * be guaranteed before the last reference is gone.
+     */
+    mce_proxy_lock(priv->proxy);
+    mce_proxy_remove_signal_handler(priv->proxy, MCE_PROXY_DISPLAY_STATUS,
+        priv->display_status_ind_id);
+    priv->display_status_ind_id = 0;
     mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    priv->proxy_valid_id = 0;
+    mce_proxy_unlock(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
+}
+
+static
+void
+mce_display_finalize(
+    GObject* object)
+{
+    MceDisplay* self = MCE_DISPLAY(object);
+    MceDisplayPriv* priv = self->priv;
+
+    mce_display_coalesce_cancel(self);
     mce_proxy_unref(priv->proxy);
+    mce_callbacks_clear(&priv->callbacks);
+    mce_history_unref(priv->history);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -305,6 +746,7 @@ mce_display_class_init(
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
 
+    object_class->dispose = mce_display_dispose;
     object_class->finalize = mce_display_finalize;
     g_type_class_add_private(klass, sizeof(MceDisplayPriv));
     mce_display_signals[SIGNAL_VALID_CHANGED] =
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_history_p.h"
+#include "mce_clock_p.h"
+#include "mce_log_p.h"
+
+struct mce_history {
+    gint ref_count;
+    GMutex mutex;
+    guint capacity;
+    guint64 written;    /* Total number of records ever added */
+    MceHistoryRecord* records;
+};
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceHistory*
+mce_history_new(
+    guint capacity)
+{
+    MceHistory* self = g_slice_new0(MceHistory);
+
+    g_atomic_int_set(&self->ref_count, 1);
+    g_mutex_init(&self->mutex);
+    self->capacity = MAX(capacity, 1);
+    self->records = g_new0(MceHistoryRecord, self->capacity);
+    return self;
+}
+
+MceHistory*
+mce_history_ref(
+    MceHistory* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->ref_count > 0);
+        g_atomic_int_inc(&self->ref_count);
+    }
+    return self;
+}
+
+void
+mce_history_unref(
+    MceHistory* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->ref_count > 0);
+        if (g_atomic_int_dec_and_test(&self->ref_count)) {
+            g_mutex_clear(&self->mutex);
+            g_free(self->records);
+            g_slice_free(MceHistory, self);
+        }
+    }
+}
+
+guint
+mce_history_count(
+    MceHistory* self)
+{
+    guint count = 0;
+
+    if (G_LIKELY(self)) {
+        g_mutex_lock(&self->mutex);
+        count = (guint)MIN(self->written, self->capacity);
+        g_mutex_unlock(&self->mutex);
+    }
+    return count;
+}
+
+guint
+mce_history_copy(
+    MceHistory* self,
+    MceHistoryRecord* records,
+    guint max)
+{
+    guint n = 0;
+
+    if (G_LIKELY(self) && G_LIKELY(records)) {
+        guint64 pos;
+
+        g_mutex_lock(&self->mutex);
+        n = (guint)MIN(MIN(self->written, self->capacity), max);
+        for (pos = self->written - n; pos < self->written; pos++) {
+            *records++ = self->records[pos % self->capacity];
+        }
+        g_mutex_unlock(&self->mutex);
+    }
+    return n;
+}
+
+void
+mce_history_iter_init(
+    MceHistoryIter* iter,
+    MceHistory* history)
+{
+    if (G_LIKELY(iter)) {
+        iter->history = history;
+        iter->pos = 0;
+    }
+}
+
+gboolean
+mce_history_iter_next(
+    MceHistoryIter* iter,
+    MceHistoryRecord* record)
+{
+    gboolean ok = FALSE;
+
+    if (G_LIKELY(iter) && G_LIKELY(iter->history)) {
+        MceHistory* self = iter->history;
+
+        g_mutex_lock(&self->mutex);
+        if (self->written > self->capacity &&
+            iter->pos < self->written - self->capacity) {
+            /* Those have been overwritten */
+            iter->pos = self->written - self->capacity;
+        }
+        if (iter->pos < self->written) {
+            if (record) {
+                *record = self->records[iter->pos % self->capacity];
+            }
+            iter->pos++;
+            ok = TRUE;
+        }
+        g_mutex_unlock(&self->mutex);
+    }
+    return ok;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+void
+mce_history_add(
+    MceHistory* self,
+    MCE_HISTORY_FIELD field,
+    gint value,
+    const MceStamp* stamp,
+    guint seq)
+{
+    MceHistoryRecord* record;
+
+    g_mutex_lock(&self->mutex);
+    record = self->records + (self->written++ % self->capacity);
+    record->time = stamp ? stamp->time : mce_clock_boottime();
+    record->seq = stamp ? stamp->seq : seq;
+    record->field = field;
+    record->value = value;
+    g_mutex_unlock(&self->mutex);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
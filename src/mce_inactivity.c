@@ -34,7 +34,12 @@
  */
 
 #include "mce_inactivity.h"
-#include "mce_proxy.h"
+#include "mce_callbacks_p.h"
+#include "mce_clock_p.h"
+#include "mce_context_p.h"
+#include "mce_history_p.h"
+#include "mce_proxy_p.h"
+#include "mce_wait_p.h"
 #include "mce_log_p.h"
 
 #include <mce/dbus-names.h>
@@ -42,14 +47,16 @@
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 struct mce_inactivity_priv {
     MceProxy* proxy;
+    MceCallbacks callbacks;
+    guint seq;              /* Last MceStamp sequence number */
+    MceHistory* history;
+    gboolean eager;         /* Always tracked, see mce_inactivity_new() */
+    guint pins;             /* Tracked regardless of the handlers */
     gulong proxy_valid_id;
     gulong inactivity_status_ind_id;
+    gboolean have_status;
 };
 
 enum mce_inactivity_signal {
@@ -63,6 +70,13 @@ enum mce_inactivity_signal {
 
 static guint mce_inactivity_signals[SIGNAL_COUNT] = { 0 };
 
+static const MCE_HISTORY_FIELD mce_inactivity_history_fields[] = {
+    MCE_HISTORY_INACTIVITY_VALID,
+    MCE_HISTORY_INACTIVITY_STATUS
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_inactivity_history_fields) == SIGNAL_COUNT);
+
 typedef GObjectClass MceInactivityClass;
 G_DEFINE_TYPE(MceInactivity, mce_inactivity, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_inactivity_parent_class
@@ -74,6 +88,51 @@ G_DEFINE_TYPE(MceInactivity, mce_inactivity, G_TYPE_OBJECT)
  * Implementation
  *==========================================================================*/
 
+static
+void
+mce_inactivity_emit(
+    MceInactivity* self,
+    enum mce_inactivity_signal sig)
+{
+    MceInactivityPriv* priv = self->priv;
+
+    if (priv->history) {
+        const MceStamp* stamp = NULL;
+        gint value = 0;
+
+        switch (sig) {
+        case SIGNAL_VALID_CHANGED:
+            value = self->valid;
+            /* Becoming valid is caused by a report, invalid is not */
+            if (self->valid) {
+                stamp = &self->status_stamp;
+            }
+            break;
+        case SIGNAL_STATUS_CHANGED:
+            value = self->status;
+            stamp = &self->status_stamp;
+            break;
+        case SIGNAL_COUNT:
+            break;
+        }
+        mce_history_add(priv->history, mce_inactivity_history_fields[sig],
+            value, stamp, priv->seq);
+    }
+    g_signal_emit(self, mce_inactivity_signals[sig], 0);
+    mce_callbacks_emit(&priv->callbacks, sig, self);
+}
+
+static
+gboolean
+mce_inactivity_has_handlers(
+    MceInactivity* self,
+    enum mce_inactivity_signal sig)
+{
+    return mce_callbacks_has(&self->priv->callbacks, sig) ||
+        g_signal_has_handler_pending(self, mce_inactivity_signals[sig], 0,
+            TRUE);
+}
+
 static
 void
 mce_inactivity_status_update(
@@ -82,77 +141,112 @@ mce_inactivity_status_update(
 {
     MceInactivityPriv* priv = self->priv;
     const gboolean prev_status = self->status;
+    priv->have_status = TRUE;
+    mce_residency_enter(mce_proxy_residency(priv->proxy,
+        MCE_PROXY_INACTIVITY_STATUS), status != FALSE,
+        self->status_stamp.time);
     self->status = status;
     if (self->status != prev_status) {
-        g_signal_emit(self, mce_inactivity_signals[SIGNAL_STATUS_CHANGED], 0);
+        mce_inactivity_emit(self, SIGNAL_STATUS_CHANGED);
     }
     if (priv->proxy->valid && !self->valid) {
         self->valid = TRUE;
-        g_signal_emit(self, mce_inactivity_signals[SIGNAL_VALID_CHANGED], 0);
+        mce_inactivity_emit(self, SIGNAL_VALID_CHANGED);
     }
 }
 
 static
 void
-mce_inactivity_status_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_inactivity_status_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
-    GError* error = NULL;
-    gboolean status = FALSE;
     MceInactivity* self = MCE_INACTIVITY(arg);
 
-    if (com_nokia_mce_request_call_get_inactivity_status_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &status, result, &error)) {
-        GDEBUG("inactivlty is currently %s", status ? "true" : "false");
-        mce_inactivity_status_update(self, status);
-    } else {
-        /*
-         * We could retry but it's probably not worth the trouble.
-         * There is signal broadcast on mce startup / when inactivity
-         * state changes.
-         * Until then, this object stays invalid.
-         */
-        GWARN("Failed to query inactivity status %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_inactivity_unref(self);
+    GDEBUG("status is %s", value->b ? "true" : "false");
+    self->status_stamp.time = value->time;
+    self->status_stamp.seq = ++self->priv->seq;
+    mce_inactivity_status_update(self, value->b);
 }
 
 static
 void
-mce_inactivity_status_ind(
-    ComNokiaMceSignal* proxy,
-    gboolean status,
-    gpointer arg)
+mce_inactivity_update_demand(
+    MceInactivity* self)
 {
-    GDEBUG("status is %s", status ? "true" : "false");
-    mce_inactivity_status_update(MCE_INACTIVITY(arg), status);
+    MceInactivityPriv* priv = self->priv;
+    gboolean demand = priv->eager || priv->pins;
+    int i;
+
+    for (i = 0; i < SIGNAL_COUNT && !demand; i++) {
+        demand = mce_inactivity_has_handlers(self, i);
+    }
+    if (demand) {
+        if (!priv->inactivity_status_ind_id) {
+            /* The first handler has been connected, start tracking */
+            priv->inactivity_status_ind_id =
+                mce_proxy_add_signal_handler(priv->proxy,
+                    MCE_PROXY_INACTIVITY_STATUS, mce_inactivity_status_ind,
+                    self);
+        }
+    } else if (priv->inactivity_status_ind_id) {
+        /* Nobody is listening, stop tracking */
+        mce_proxy_remove_signal_handler(priv->proxy,
+            MCE_PROXY_INACTIVITY_STATUS, priv->inactivity_status_ind_id);
+        priv->inactivity_status_ind_id = 0;
+        priv->have_status = FALSE;
+        if (self->valid) {
+            self->valid = FALSE;
+            mce_inactivity_emit(self, SIGNAL_VALID_CHANGED);
+        }
+    }
 }
 
 static
-void
-mce_inactivity_status_query(
-    MceInactivity* self)
+gulong
+mce_inactivity_add_handler(
+    MceInactivity* self,
+    const char* name,
+    MceInactivityFunc fn,
+    void* arg,
+    gboolean in_context)
 {
-    MceInactivityPriv* priv = self->priv;
-    MceProxy* proxy = priv->proxy;
-
-    /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceInactivity is created. In that case we have to wait
-     * for the valid signal before we can connect the inactivity status
-     * signal and submit the initial query.
-     */
-    if (proxy->signal && !priv->inactivity_status_ind_id) {
-        priv->inactivity_status_ind_id = g_signal_connect(proxy->signal,
-            MCE_INACTIVITY_SIG, G_CALLBACK(mce_inactivity_status_ind), self);
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = in_context ?
+            mce_context_connect(self, name, G_CALLBACK(fn), arg) :
+            g_signal_connect(self, name, G_CALLBACK(fn), arg);
+        mce_inactivity_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
-    if (proxy->request && proxy->valid) {
-        com_nokia_mce_request_call_get_inactivity_status(proxy->request, NULL,
-            mce_inactivity_status_query_done, mce_inactivity_ref(self));
+    return 0;
+}
+
+static
+gulong
+mce_inactivity_add_callback(
+    MceInactivity* self,
+    enum mce_inactivity_signal sig,
+    MceInactivityFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add(&self->priv->callbacks, sig, G_CALLBACK(fn),
+            arg);
+        mce_inactivity_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
+    return 0;
 }
 
 static
@@ -164,15 +258,81 @@ mce_inactivity_valid_changed(
     MceInactivity* self = MCE_INACTIVITY(arg);
 
     if (proxy->valid) {
-        mce_inactivity_status_query(self);
+        if (self->priv->have_status && !self->valid) {
+            /* The initial query has completed before the name appeared */
+            self->valid = TRUE;
+            mce_inactivity_emit(self, SIGNAL_VALID_CHANGED);
+        }
     } else {
+        self->priv->have_status = FALSE;
+        mce_residency_leave(mce_proxy_residency(self->priv->proxy,
+            MCE_PROXY_INACTIVITY_STATUS), mce_clock_boottime());
         if (self->valid) {
             self->valid = FALSE;
-            g_signal_emit(self, mce_inactivity_signals[SIGNAL_VALID_CHANGED], 0);
+            mce_inactivity_emit(self, SIGNAL_VALID_CHANGED);
         }
     }
 }
 
+static
+void
+mce_inactivity_pin(
+    gpointer object)
+{
+    MceInactivity* self = MCE_INACTIVITY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    self->priv->pins++;
+    mce_inactivity_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+void
+mce_inactivity_unpin(
+    gpointer object)
+{
+    MceInactivity* self = MCE_INACTIVITY(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    GASSERT(self->priv->pins);
+    self->priv->pins--;
+    mce_inactivity_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+MceInactivity*
+mce_inactivity_create(
+    MceProxy* proxy,
+    gboolean eager)
+{
+    /* Eager and lazy objects don't share the state */
+    const MCE_PROXY_OBJECT type = eager ?
+        MCE_PROXY_OBJECT_INACTIVITY_EAGER :
+        MCE_PROXY_OBJECT_INACTIVITY;
+    MceInactivity* self;
+
+    mce_proxy_lock(proxy);
+    self = mce_proxy_object_ref(proxy, type);
+    if (!self) {
+        MceInactivityPriv* priv;
+
+        self = g_object_new(MCE_INACTIVITY_TYPE, NULL);
+        priv = self->priv;
+        priv->proxy = mce_proxy_ref(proxy);
+        priv->eager = eager;
+        priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(proxy,
+            mce_inactivity_valid_changed, self);
+        mce_inactivity_update_demand(self);
+        mce_proxy_object_set(proxy, type, self);
+    }
+    mce_proxy_unlock(proxy);
+    return self;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -180,17 +340,30 @@ mce_inactivity_valid_changed(
 MceInactivity*
 mce_inactivity_new()
 {
-    static MceInactivity* mce_inactivity_instance = NULL;
+    MceProxy* proxy = mce_proxy_new();
+    MceInactivity* self = mce_inactivity_create(proxy, TRUE);
 
-    if (mce_inactivity_instance) {
-        mce_inactivity_ref(mce_inactivity_instance);
-    } else {
-        mce_inactivity_instance = g_object_new(MCE_INACTIVITY_TYPE, NULL);
-        mce_inactivity_status_query(mce_inactivity_instance);
-        g_object_add_weak_pointer(G_OBJECT(mce_inactivity_instance),
-            (gpointer*)(&mce_inactivity_instance));
-    }
-    return mce_inactivity_instance;
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceInactivity*
+mce_inactivity_new_for_proxy(
+    MceProxy* proxy)
+{
+    return G_LIKELY(proxy) ? mce_inactivity_create(proxy, FALSE) : NULL;
+}
+
+MceInactivity*
+mce_inactivity_new_sync(
+    guint timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceInactivity* self = mce_inactivity_create(proxy, TRUE);
+
+    mce_proxy_sync(proxy, timeout_ms);
+    mce_proxy_unref(proxy);
+    return self;
 }
 
 MceInactivity*
@@ -218,8 +391,18 @@ mce_inactivity_add_valid_changed_handler(
     MceInactivityFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_inactivity_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_inactivity_add_valid_changed_handler_in_context(
+    MceInactivity* self,
+    MceInactivityFunc fn,
+    void* arg)
+{
+    return mce_inactivity_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -228,8 +411,18 @@ mce_inactivity_add_status_changed_handler(
     MceInactivityFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_STATUS_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_inactivity_add_handler(self, SIGNAL_STATUS_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_inactivity_add_status_changed_handler_in_context(
+    MceInactivity* self,
+    MceInactivityFunc fn,
+    void* arg)
+{
+    return mce_inactivity_add_handler(self, SIGNAL_STATUS_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 void
@@ -238,7 +431,12 @@ mce_inactivity_remove_handler(
     gulong id)
 {
     if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
         g_signal_handler_disconnect(self, id);
+        mce_inactivity_update_demand(self);
+        mce_proxy_unlock(proxy);
     }
 }
 
@@ -248,7 +446,89 @@ mce_inactivity_remove_handlers(
     gulong* ids,
     guint count)
 {
-    gutil_disconnect_handlers(self, ids, count);
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        gutil_disconnect_handlers(self, ids, count);
+        mce_inactivity_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_inactivity_add_valid_changed_callback(
+    MceInactivity* self,
+    MceInactivityFunc fn,
+    void* arg)
+{
+    return mce_inactivity_add_callback(self, SIGNAL_VALID_CHANGED, fn, arg);
+}
+
+gulong
+mce_inactivity_add_status_changed_callback(
+    MceInactivity* self,
+    MceInactivityFunc fn,
+    void* arg)
+{
+    return mce_inactivity_add_callback(self, SIGNAL_STATUS_CHANGED, fn, arg);
+}
+
+void
+mce_inactivity_remove_callback(
+    MceInactivity* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        mce_callbacks_remove(&self->priv->callbacks, id);
+        mce_inactivity_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_inactivity_set_history(
+    MceInactivity* self,
+    MceHistory* history)
+{
+    if (G_LIKELY(self)) {
+        MceInactivityPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        if (priv->history != history) {
+            mce_history_unref(priv->history);
+            priv->history = mce_history_ref(history);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_inactivity_wait_valid_async(
+    MceInactivity* self,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(self)) {
+        mce_wait_valid_async(self, SIGNAL_VALID_CHANGED_NAME, &self->valid,
+            mce_inactivity_pin, mce_inactivity_unpin, timeout_ms,
+            cancellable, callback, user_data);
+    }
+}
+
+gboolean
+mce_inactivity_wait_valid_finish(
+    MceInactivity* self,
+    GAsyncResult* result,
+    GError** error)
+{
+    return mce_wait_valid_finish(self, result, error);
 }
 
 /*==========================================================================*
@@ -265,25 +545,38 @@ mce_inactivity_init(
 
     self->priv = priv;
     self->status = FALSE;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_inactivity_valid_changed, self);
 }
 
 static
 void
-mce_inactivity_finalize(
+mce_inactivity_dispose(
     GObject* object)
 {
     MceInactivity* self = MCE_INACTIVITY(object);
     MceInactivityPriv* priv = self->priv;
 
-    if (priv->inactivity_status_ind_id) {
-        g_signal_handler_disconnect(priv->proxy->signal,
-            priv->inactivity_status_ind_id);
-    }
+    /* Disconnect from the proxy while the object is still alive */
+    mce_proxy_lock(priv->proxy);
+    mce_proxy_remove_signal_handler(priv->proxy, MCE_PROXY_INACTIVITY_STATUS,
+        priv->inactivity_status_ind_id);
+    priv->inactivity_status_ind_id = 0;
     mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    priv->proxy_valid_id = 0;
+    mce_proxy_unlock(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
+}
+
+static
+void
+mce_inactivity_finalize(
+    GObject* object)
+{
+    MceInactivity* self = MCE_INACTIVITY(object);
+    MceInactivityPriv* priv = self->priv;
+
     mce_proxy_unref(priv->proxy);
+    mce_callbacks_clear(&priv->callbacks);
+    mce_history_unref(priv->history);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -294,6 +587,7 @@ mce_inactivity_class_init(
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
 
+    object_class->dispose = mce_inactivity_dispose;
     object_class->finalize = mce_inactivity_finalize;
     g_type_class_add_private(klass, sizeof(MceInactivityPriv));
     mce_inactivity_signals[SIGNAL_VALID_CHANGED] =
@@ -34,39 +34,745 @@
  * any official policies, either expressed or implied.
  */
 
-#include "mce_proxy.h"
+#include "mce_proxy_p.h"
+#include "mce_clock_p.h"
 #include "mce_log_p.h"
 
 #include "mce/dbus-names.h"
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 GLOG_MODULE_DEFINE("mce");
 
+typedef struct mce_proxy_signal_handler {
+    gulong id;
+    MceProxySignalFunc fn;  /* NULL if removed during dispatch */
+    void* arg;
+    gboolean fresh;         /* Waiting for the cached value */
+} MceProxySignalHandler;
+
+typedef struct mce_proxy_ind {
+    MceProxy* proxy;
+    guint subscription;
+    guint active;           /* Handlers with non-NULL fn */
+    guint count;
+    guint dispatching;
+    MceProxySignalHandler* handlers;
+    gboolean query_pending; /* Query in flight (or retry scheduled) */
+    gboolean known;         /* Value received in the current generation */
+    MceProxyValue value;    /* The last one, meaningful if known */
+    char* str;              /* Owns value.str */
+    gboolean query_scheduled; /* Requested outside of the proxy context */
+    guint retry_count;
+    GSource* retry;
+} MceProxyInd;
+
+/*
+ * The recursive mutex protects the proxy and the objects attached to
+ * it. It's held while the callbacks are invoked, so that a handler
+ * removed on another thread is guaranteed not to be running anymore.
+ */
 struct mce_proxy_priv {
+    GRecMutex mutex;
+    GMainContext* context;
+    GSource* kick;
     GDBusConnection* bus;
+    gulong bus_closed_id;
+    gboolean system_bus;    /* Owns its system bus connection */
+    gboolean reconnect;     /* Reconnect to the system bus if it closes */
+    GSource* reconnect_timer;
+    guint reconnect_count;
+    gint64 closed_time;     /* Monotonic time of the close, 0 if none */
+    char* service;
+    char* request_path;
+    char* signal_path;
     guint mce_watch_id;
+    gboolean name_known;    /* Name watcher has reported the owner */
+    gboolean name_owned;
+    guint generation;       /* Incremented when mce goes away */
+    GCancellable* cancellable; /* Cancelled when mce goes away */
+    guint resync_pending;   /* Bitmask of MCE_PROXY_PROPERTY */
+    MceProxyRetryPolicy retry_policy;
+    MceProxyStats stats;
+    MceResidencyCounter residency[MCE_PROXY_PROPERTY_COUNT];
+    gulong last_signal_handler_id;
+    MceProxyTapFunc tap;
+    void* tap_arg;
+    MceProxyInd ind[MCE_PROXY_PROPERTY_COUNT];
+    GWeakRef object[MCE_PROXY_OBJECT_COUNT];
+};
+
+/*
+ * GDBus callbacks and timers don't keep the proxy alive. The last
+ * reference may be released on another thread at any time, so they
+ * have to get their own reference from the weak one before touching
+ * the proxy.
+ */
+typedef struct mce_proxy_weak {
+    GWeakRef ref;
+    MCE_PROXY_PROPERTY property; /* Not used by the bus callbacks */
+} MceProxyWeak;
+
+/* If mce disappears, the cancellable is cancelled */
+typedef struct mce_proxy_call {
+    MceProxyWeak proxy;
+    GCancellable* cancellable;
+} MceProxyCall;
+
+typedef struct mce_proxy_property_desc {
+    const char* method;
+    const char* signal;
+    const char* type; /* Both the reply and the signal arguments */
+} MceProxyPropertyDesc;
+
+static const MceProxyPropertyDesc mce_proxy_properties[] = {
+    /* MCE_PROXY_DISPLAY_STATUS */
+    { "get_display_status", "display_status_ind", "(s)" },
+    /* MCE_PROXY_TKLOCK_MODE */
+    { "get_tklock_mode", "tklock_mode_ind", "(s)" },
+    /* MCE_PROXY_BATTERY_LEVEL */
+    { "get_battery_level", "battery_level_ind", "(i)" },
+    /* MCE_PROXY_BATTERY_STATUS */
+    { "get_battery_status", "battery_status_ind", "(s)" },
+    /* MCE_PROXY_CHARGER_STATE */
+    { "get_charger_state", "charger_state_ind", "(s)" },
+    /* MCE_PROXY_INACTIVITY_STATUS */
+    { "get_inactivity_status", "system_inactivity_ind", "(b)" }
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_proxy_properties) ==
+    MCE_PROXY_PROPERTY_COUNT);
+
+/*
+ * Since there's only one mce in the system, there's no need for
+ * more than one proxy object. The weak reference returns NULL as
+ * soon as the last reference is gone, even if the finalization
+ * is still in progress on another thread.
+ */
+G_LOCK_DEFINE_STATIC(mce_proxy_instance);
+static GWeakRef mce_proxy_instance;
+
+static const MceProxyRetryPolicy mce_proxy_default_retry_policy = {
+    5000,   /* call_timeout_ms */
+    5,      /* max_retries */
+    500,    /* initial_delay_ms */
+    30000,  /* max_delay_ms */
+    25      /* jitter_percent */
 };
 
 enum mce_proxy_signal {
     SIGNAL_VALID_CHANGED,
+    SIGNAL_RESYNC_DONE,
     SIGNAL_COUNT
 };
 
 #define SIGNAL_VALID_CHANGED_NAME   "mce-proxy-valid-changed"
+#define SIGNAL_RESYNC_DONE_NAME     "mce-proxy-resync-done"
 
 static guint mce_proxy_signals[SIGNAL_COUNT] = { 0 };
 
 typedef GObjectClass MceProxyClass;
-GType mce_proxy_get_type() MCE_INTERNAL;
 G_DEFINE_TYPE(MceProxy, mce_proxy, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_proxy_parent_class
 #define MCE_PROXY_TYPE (mce_proxy_get_type())
 #define MCE_PROXY(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
         MCE_PROXY_TYPE,MceProxy))
 
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+gpointer
+mce_proxy_weak_new(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyWeak* weak = g_slice_new(MceProxyWeak);
+
+    g_weak_ref_init(&weak->ref, self);
+    weak->property = property;
+    return weak;
+}
+
+static
+void
+mce_proxy_weak_free(
+    gpointer data)
+{
+    MceProxyWeak* weak = data;
+
+    g_weak_ref_clear(&weak->ref);
+    g_slice_free(MceProxyWeak, weak);
+}
+
+static
+void
+mce_proxy_weak_closure_free(
+    gpointer data,
+    GClosure* closure)
+{
+    mce_proxy_weak_free(data);
+}
+
+static
+MceProxy*
+mce_proxy_weak_get(
+    gpointer data)
+{
+    /* Returns NULL if the proxy is being finalized */
+    return g_weak_ref_get(&((MceProxyWeak*)data)->ref);
+}
+
+static
+void
+mce_proxy_update_valid(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+    const gboolean valid = priv->name_owned;
+
+    if (self->valid != valid) {
+        self->valid = valid;
+        g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    }
+}
+
+static
+gboolean
+mce_proxy_decode(
+    MCE_PROXY_PROPERTY property,
+    GVariant* args,
+    MceProxyValue* value)
+{
+    const char* type = mce_proxy_properties[property].type;
+
+    memset(value, 0, sizeof(*value));
+    value->time = mce_clock_boottime();
+    if (g_variant_is_of_type(args, G_VARIANT_TYPE(type))) {
+        /*
+         * GDBus builds message arguments in tree form, so fetching
+         * the child just bumps its reference count. The string is
+         * borrowed from the message and stays valid as long as args
+         * is alive, nothing gets copied.
+         */
+        GVariant* child = g_variant_get_child_value(args, 0);
+
+        switch (type[1]) {
+        case 's':
+            value->str = g_variant_get_string(child, NULL);
+            break;
+        case 'i':
+            value->i = g_variant_get_int32(child);
+            break;
+        case 'b':
+            value->b = g_variant_get_boolean(child);
+            break;
+        }
+        g_variant_unref(child);
+        return TRUE;
+    } else {
+        GWARN("Unexpected %s signature %s",
+            mce_proxy_properties[property].signal,
+            g_variant_get_type_string(args));
+        return FALSE;
+    }
+}
+
+static
+void
+mce_proxy_ind_compact(
+    MceProxyInd* ind)
+{
+    guint i, n = 0;
+
+    for (i = 0; i < ind->count; i++) {
+        if (ind->handlers[i].fn) {
+            ind->handlers[n++] = ind->handlers[i];
+        }
+    }
+    ind->count = n;
+}
+
+static
+void
+mce_proxy_ind_dispatch(
+    MceProxyInd* ind,
+    const MceProxyValue* value)
+{
+    MceProxy* self = ind->proxy;
+    const guint count = ind->count;
+    guint i;
+
+    if (!ind->active) {
+        /*
+         * A reply (or a signal) which was already on its way when the
+         * last handler was removed. Nobody needs it, and the value
+         * must not be considered known.
+         */
+        return;
+    }
+
+    /*
+     * The handlers are invoked directly, without going through
+     * GSignal and its marshallers. Handlers may release the last
+     * reference to the proxy.
+     */
+    mce_proxy_ref(self);
+    if (self->priv->tap) {
+        self->priv->tap(self, ind - self->priv->ind, value,
+            self->priv->tap_arg);
+    }
+    if (value->str != ind->str) {
+        g_free(ind->str);
+        ind->str = g_strdup(value->str);
+    }
+    ind->value = *value;
+    ind->value.str = ind->str;
+    ind->known = TRUE;
+    ind->dispatching++;
+    for (i = 0; i < count; i++) {
+        MceProxySignalHandler* handler = ind->handlers + i;
+
+        if (handler->fn) {
+            handler->fresh = FALSE;
+            handler->fn(self, value, handler->arg);
+        }
+    }
+    if (!--ind->dispatching && ind->active < ind->count) {
+        mce_proxy_ind_compact(ind);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_ind_dispatch_cached(
+    MceProxyInd* ind)
+{
+    MceProxy* self = ind->proxy;
+    const guint count = ind->count;
+    guint i;
+
+    /* Only the handlers which haven't seen the current value yet */
+    mce_proxy_ref(self);
+    ind->dispatching++;
+    for (i = 0; i < count && ind->known; i++) {
+        MceProxySignalHandler* handler = ind->handlers + i;
+
+        if (handler->fn && handler->fresh) {
+            handler->fresh = FALSE;
+            handler->fn(self, &ind->value, handler->arg);
+        }
+    }
+    if (!--ind->dispatching && ind->active < ind->count) {
+        mce_proxy_ind_compact(ind);
+    }
+    mce_proxy_unref(self);
+}
+
+static
+void
+mce_proxy_resync_finished(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    GDEBUG("Resync %u done", priv->generation);
+    if (priv->closed_time) {
+        /* The state has been fully restored after the bus had closed */
+        const guint ms = (guint)((g_get_monotonic_time() -
+            priv->closed_time) / 1000);
+
+        GDEBUG("Recovered in %u ms", ms);
+        priv->closed_time = 0;
+        priv->stats.recoveries++;
+        priv->stats.last_recovery_ms = ms;
+        priv->stats.max_recovery_ms = MAX(priv->stats.max_recovery_ms, ms);
+    }
+    g_signal_emit(self, mce_proxy_signals[SIGNAL_RESYNC_DONE], 0);
+}
+
+static
+void
+mce_proxy_resync_done(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (priv->resync_pending & (1 << property)) {
+        priv->resync_pending &= ~(1 << property);
+        if (!priv->resync_pending) {
+            mce_proxy_resync_finished(self);
+        }
+    }
+}
+
+static
+void
+mce_proxy_call_free(
+    MceProxyCall* call)
+{
+    g_weak_ref_clear(&call->proxy.ref);
+    g_object_unref(call->cancellable);
+    g_slice_free(MceProxyCall, call);
+}
+
+static
+gboolean
+mce_proxy_retry(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property,
+    const GError* error);
+
+static
+void
+mce_proxy_call_done(
+    GObject* bus,
+    GAsyncResult* result,
+    gpointer data)
+{
+    MceProxyCall* call = data;
+    const MCE_PROXY_PROPERTY property = call->proxy.property;
+    const MceProxyPropertyDesc* desc = mce_proxy_properties + property;
+    GError* error = NULL;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(bus),
+        result, &error);
+    MceProxy* self = mce_proxy_weak_get(&call->proxy);
+
+    if (self) {
+        mce_proxy_lock(self);
+    }
+    /* Checked under the lock, mce_proxy_reset() cancels it */
+    if (!self || g_cancellable_is_cancelled(call->cancellable)) {
+        /* The proxy is gone or this reply is from the previous mce */
+        GDEBUG("Dropping %s reply", desc->method);
+    } else {
+        MceProxyPriv* priv = self->priv;
+        MceProxyInd* ind = priv->ind + property;
+
+        if (reply) {
+            MceProxyValue value;
+
+            /* The reply type has already been checked by GDBus */
+            ind->query_pending = FALSE;
+            ind->retry_count = 0;
+            mce_proxy_decode(property, reply, &value);
+            mce_proxy_ind_dispatch(ind, &value);
+            mce_proxy_resync_done(self, property);
+        } else {
+            GWARN("Failed to query %s: %s", desc->method, GERRMSG(error));
+            priv->stats.failures++;
+            if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT)) {
+                priv->stats.timeouts++;
+            }
+            if (!mce_proxy_retry(self, property, error)) {
+                ind->query_pending = FALSE;
+                ind->retry_count = 0;
+                mce_proxy_resync_done(self, property);
+            }
+        }
+    }
+    if (self) {
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
+    }
+    if (reply) {
+        g_variant_unref(reply);
+    } else {
+        g_error_free(error);
+    }
+    mce_proxy_call_free(call);
+}
+
+static
+void
+mce_proxy_call_submit(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyPriv* priv = self->priv;
+    const MceProxyPropertyDesc* desc = mce_proxy_properties + property;
+    const guint timeout = priv->retry_policy.call_timeout_ms;
+    MceProxyCall* call = g_slice_new(MceProxyCall);
+
+    g_weak_ref_init(&call->proxy.ref, self);
+    call->proxy.property = property;
+    call->cancellable = g_object_ref(priv->cancellable);
+    priv->stats.queries++;
+
+    /*
+     * Don't wait for the name owner to be resolved. If mce isn't
+     * there, the call simply fails and gets repeated when the name
+     * appears.
+     */
+    g_dbus_connection_call(priv->bus, priv->service,
+        priv->request_path, MCE_REQUEST_IF, desc->method, NULL,
+        G_VARIANT_TYPE(desc->type), G_DBUS_CALL_FLAGS_NO_AUTO_START,
+        timeout ? (int)timeout : -1, priv->cancellable,
+        mce_proxy_call_done, call);
+}
+
+static
+gboolean
+mce_proxy_retry_cb(
+    gpointer data)
+{
+    MceProxy* self = mce_proxy_weak_get(data);
+
+    if (self) {
+        const MCE_PROXY_PROPERTY property = ((MceProxyWeak*)data)->property;
+        MceProxyInd* ind = self->priv->ind + property;
+
+        mce_proxy_lock(self);
+        g_source_unref(ind->retry);
+        ind->retry = NULL;
+        mce_proxy_call_submit(self, property);
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+guint
+mce_proxy_backoff_delay(
+    const MceProxyRetryPolicy* policy,
+    guint attempt)
+{
+    guint delay = policy->initial_delay_ms;
+    guint i;
+
+    /* Exponential backoff with jitter */
+    for (i = 0; i < attempt && delay < policy->max_delay_ms; i++) {
+        delay *= 2;
+    }
+    delay = MIN(delay, policy->max_delay_ms);
+    if (policy->jitter_percent && delay) {
+        const gint32 range = (gint32)(((guint64)delay *
+            MIN(policy->jitter_percent, 100)) / 100);
+
+        delay += g_random_int_range(-range, range + 1);
+    }
+    return delay;
+}
+
+static
+gboolean
+mce_proxy_retry(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property,
+    const GError* error)
+{
+    MceProxyPriv* priv = self->priv;
+    MceProxyInd* ind = priv->ind + property;
+    const MceProxyRetryPolicy* policy = &priv->retry_policy;
+
+    if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER)) {
+        /* There's no mce, the query gets repeated when it shows up */
+        return FALSE;
+    } else if (ind->active && ind->retry_count < policy->max_retries) {
+        const guint delay = mce_proxy_backoff_delay(policy,
+            ind->retry_count);
+
+        ind->retry_count++;
+        priv->stats.retries++;
+        GDEBUG("Retrying %s in %u ms (attempt %u)",
+            mce_proxy_properties[property].method, delay,
+            ind->retry_count);
+        ind->retry = g_timeout_source_new(delay);
+        g_source_set_callback(ind->retry, mce_proxy_retry_cb,
+            mce_proxy_weak_new(self, property), mce_proxy_weak_free);
+        g_source_attach(ind->retry, priv->context);
+        return TRUE;
+    } else {
+        if (ind->retry_count) {
+            priv->stats.gave_up++;
+        }
+        return FALSE;
+    }
+}
+
+static
+void
+mce_proxy_cancel_retry(
+    MceProxyInd* ind)
+{
+    if (ind->retry) {
+        g_source_destroy(ind->retry);
+        g_source_unref(ind->retry);
+        ind->retry = NULL;
+        ind->query_pending = FALSE;
+    }
+    ind->retry_count = 0;
+}
+
+static
+void
+mce_proxy_query(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyPriv* priv = self->priv;
+    MceProxyInd* ind = priv->ind + property;
+
+    /* There's never more than one query per property in flight */
+    if (priv->bus && !ind->query_pending) {
+        ind->query_pending = TRUE;
+        mce_proxy_call_submit(self, property);
+    }
+}
+
+static
+void
+mce_proxy_resync(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+    int i;
+
+    /*
+     * One batch of queries per mce incarnation. Whatever is already
+     * known or being queried doesn't get queried again.
+     */
+    priv->resync_pending = 0;
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        MceProxyInd* ind = priv->ind + i;
+
+        if (ind->active && !ind->known) {
+            priv->resync_pending |= (1 << i);
+            mce_proxy_query(self, i);
+        }
+    }
+    if (priv->resync_pending) {
+        GDEBUG("Resync %u started", priv->generation);
+    } else {
+        mce_proxy_resync_finished(self);
+    }
+}
+
+static
+void
+mce_proxy_signal_cb(
+    GDBusConnection* bus,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* member,
+    GVariant* args,
+    gpointer data)
+{
+    MceProxy* self = mce_proxy_weak_get(data);
+    const MCE_PROXY_PROPERTY property = ((MceProxyWeak*)data)->property;
+    MceProxyValue value;
+
+    /*
+     * Each signal has its own subscription, there's no need to look
+     * at the member name.
+     */
+    if (self) {
+        if (mce_proxy_decode(property, args, &value)) {
+            mce_proxy_lock(self);
+            mce_proxy_ind_dispatch(self->priv->ind + property, &value);
+            mce_proxy_unlock(self);
+        }
+        mce_proxy_unref(self);
+    }
+}
+
+static
+void
+mce_proxy_subscribe(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyPriv* priv = self->priv;
+    MceProxyInd* ind = priv->ind + property;
+
+    GASSERT(!ind->subscription);
+    ind->subscription =
+        g_dbus_connection_signal_subscribe(priv->bus, priv->service,
+            MCE_SIGNAL_IF, mce_proxy_properties[property].signal,
+            priv->signal_path, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+            mce_proxy_signal_cb, mce_proxy_weak_new(self, property),
+            mce_proxy_weak_free);
+}
+
+static
+void
+mce_proxy_unsubscribe(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    MceProxyPriv* priv = self->priv;
+    MceProxyInd* ind = priv->ind + property;
+
+    if (ind->subscription) {
+        g_dbus_connection_signal_unsubscribe(priv->bus,
+            ind->subscription);
+        ind->subscription = 0;
+    }
+}
+
+static
+gboolean
+mce_proxy_in_context(
+    MceProxy* self)
+{
+    GMainContext* context = g_main_context_get_thread_default();
+
+    /* GDBus uses the thread-default context of the calling thread */
+    return (context ? context : g_main_context_default()) ==
+        self->priv->context;
+}
+
+static
+gboolean
+mce_proxy_kick_cb(
+    gpointer data)
+{
+    MceProxy* self = MCE_PROXY(data);
+    MceProxyPriv* priv = self->priv;
+    int i;
+
+    mce_proxy_lock(self);
+    g_source_unref(priv->kick);
+    priv->kick = NULL;
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        MceProxyInd* ind = priv->ind + i;
+
+        if (ind->active && priv->bus && !ind->subscription) {
+            mce_proxy_subscribe(self, i);
+        }
+        if (ind->query_scheduled) {
+            ind->query_scheduled = FALSE;
+            if (ind->active) {
+                mce_proxy_query(self, i);
+            }
+        }
+        if (ind->known) {
+            mce_proxy_ind_dispatch_cached(ind);
+        }
+    }
+    mce_proxy_unlock(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_proxy_kick(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    if (!priv->kick) {
+        priv->kick = g_idle_source_new();
+        g_source_set_callback(priv->kick, mce_proxy_kick_cb,
+            mce_proxy_ref(self), g_object_unref);
+        g_source_attach(priv->kick, priv->context);
+    }
+}
+
 static
 void
 mce_name_appeared(
@@ -75,12 +781,43 @@ mce_name_appeared(
     const gchar* owner,
     gpointer arg)
 {
-    MceProxy* self = MCE_PROXY(arg);
+    MceProxy* self = mce_proxy_weak_get(arg);
 
-    GDEBUG("Name '%s' is owned by %s", name, owner);
-    GASSERT(!self->valid);
-    self->valid = TRUE;
-    g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    if (self) {
+        GDEBUG("Name '%s' is owned by %s", name, owner);
+        mce_proxy_lock(self);
+        self->priv->name_known = TRUE;
+        self->priv->name_owned = TRUE;
+        mce_proxy_update_valid(self);
+        mce_proxy_resync(self);
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
+    }
+}
+
+static
+void
+mce_proxy_reset(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+    int i;
+
+    /* Cancel the calls submitted so far */
+    g_cancellable_cancel(priv->cancellable);
+    g_object_unref(priv->cancellable);
+    priv->cancellable = g_cancellable_new();
+    priv->generation++;
+    priv->resync_pending = 0;
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        MceProxyInd* ind = priv->ind + i;
+
+        mce_proxy_cancel_retry(ind);
+        ind->query_pending = FALSE;
+        ind->known = FALSE;
+    }
+    priv->name_owned = FALSE;
+    mce_proxy_update_valid(self);
 }
 
 static
@@ -90,69 +827,172 @@ mce_name_vanished(
     const gchar* name,
     gpointer arg)
 {
-    MceProxy* self = MCE_PROXY(arg);
+    MceProxy* self = mce_proxy_weak_get(arg);
 
-    GDEBUG("Name '%s' has disappeared", name);
-    if (self->valid) {
-        self->valid = FALSE;
-        g_signal_emit(self, mce_proxy_signals[SIGNAL_VALID_CHANGED], 0);
+    if (self) {
+        GDEBUG("Name '%s' has disappeared", name);
+        mce_proxy_lock(self);
+        self->priv->name_known = TRUE;
+        mce_proxy_reset(self);
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
     }
 }
 
 static
 void
-mce_proxy_init_check(
+mce_proxy_detach(
     MceProxy* self)
 {
     MceProxyPriv* priv = self->priv;
+    int i;
 
-    if (self->signal && self->request && !priv->mce_watch_id) {
-        priv->mce_watch_id = g_bus_watch_name_on_connection(priv->bus,
-            MCE_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE,
-            mce_name_appeared, mce_name_vanished, self, NULL);
+    if (priv->mce_watch_id) {
+        g_bus_unwatch_name(priv->mce_watch_id);
+        priv->mce_watch_id = 0;
+    }
+    priv->name_known = FALSE;
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        mce_proxy_unsubscribe(self, i);
     }
+    g_signal_handler_disconnect(priv->bus, priv->bus_closed_id);
+    priv->bus_closed_id = 0;
+    g_object_unref(priv->bus);
+    priv->bus = NULL;
 }
 
 static
 void
-mce_proxy_request_proxy_new_finished(
+mce_proxy_bus_get_finished(
     GObject* object,
     GAsyncResult* result,
-    gpointer arg)
+    gpointer arg);
+
+static
+gboolean
+mce_proxy_reconnect_cb(
+    gpointer data)
 {
-    MceProxy* self = MCE_PROXY(arg);
-    GError* error = NULL;
+    MceProxy* self = mce_proxy_weak_get(data);
 
-    GASSERT(!self->request);
-    self->request = com_nokia_mce_request_proxy_new_finish(result, &error);
-    if (self->request) {
-        mce_proxy_init_check(self);
-    } else {
-        GERR("Failed to initialize MCE request proxy: %s", GERRMSG(error));
-        g_error_free(error);
+    if (self) {
+        MceProxyPriv* priv = self->priv;
+
+        mce_proxy_lock(self);
+        g_source_unref(priv->reconnect_timer);
+        priv->reconnect_timer = NULL;
+        priv->reconnect_count++;
+        priv->stats.reconnects++;
+        GDEBUG("Reconnecting to system bus (attempt %u)",
+            priv->reconnect_count);
+        g_bus_get(G_BUS_TYPE_SYSTEM, NULL, mce_proxy_bus_get_finished,
+            mce_proxy_ref(self));
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
     }
-    mce_proxy_unref(self);
+    return G_SOURCE_REMOVE;
 }
 
 static
 void
-mce_proxy_signal_proxy_new_finished(
-    GObject* object,
-    GAsyncResult* result,
+mce_proxy_schedule_reconnect(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+
+    /* The delays are bounded by the retry policy, attempts are not */
+    if (priv->reconnect && !priv->reconnect_timer) {
+        const guint delay = mce_proxy_backoff_delay(&priv->retry_policy,
+            priv->reconnect_count);
+
+        GDEBUG("Reconnecting in %u ms", delay);
+        priv->reconnect_timer = g_timeout_source_new(delay);
+        g_source_set_callback(priv->reconnect_timer, mce_proxy_reconnect_cb,
+            mce_proxy_weak_new(self, 0), mce_proxy_weak_free);
+        g_source_attach(priv->reconnect_timer, priv->context);
+    }
+}
+
+static
+void
+mce_proxy_bus_closed(
+    GDBusConnection* bus,
+    gboolean remote_peer_vanished,
+    GError* error,
     gpointer arg)
 {
-    MceProxy* self = MCE_PROXY(arg);
-    GError* error = NULL;
+    MceProxy* self = mce_proxy_weak_get(arg);
+
+    if (self) {
+        MceProxyPriv* priv = self->priv;
+
+        GWARN("Bus connection closed%s%s", error ? ": " : "",
+            error ? error->message : "");
+        mce_proxy_lock(self);
+        if (priv->bus == bus) {
+            /*
+             * Handler ids remain valid, the signals get subscribed to
+             * again once the connection is back.
+             */
+            priv->stats.disconnects++;
+            priv->closed_time = g_get_monotonic_time();
+            priv->reconnect_count = 0;
+            mce_proxy_detach(self);
+            mce_proxy_reset(self);
+            mce_proxy_schedule_reconnect(self);
+        }
+        mce_proxy_unlock(self);
+        mce_proxy_unref(self);
+    }
+}
+
+static
+void
+mce_proxy_attach(
+    MceProxy* self,
+    GDBusConnection* bus)
+{
+    MceProxyPriv* priv = self->priv;
+    int i;
 
-    GASSERT(!self->signal);
-    self->signal = com_nokia_mce_signal_proxy_new_finish(result, &error);
-    if (self->signal) {
-        mce_proxy_init_check(self);
+    priv->bus = bus;
+    if (priv->reconnect) {
+        /* Otherwise GDBus would terminate the process on close */
+        g_dbus_connection_set_exit_on_close(bus, FALSE);
+    }
+    priv->bus_closed_id = g_signal_connect_data(bus, "closed",
+        G_CALLBACK(mce_proxy_bus_closed), mce_proxy_weak_new(self, 0),
+        mce_proxy_weak_closure_free, 0);
+
+    /*
+     * Everything that's needed to make the objects valid is
+     * submitted at once, without waiting for any of the replies.
+     * The requests get pipelined on the connection, and the
+     * whole bootstrap takes roughly one round trip.
+     */
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        if (priv->ind[i].active) {
+            mce_proxy_subscribe(self, i);
+        }
+    }
+    if (priv->service) {
+        priv->mce_watch_id = g_bus_watch_name_on_connection(bus,
+            priv->service, G_BUS_NAME_WATCHER_FLAGS_NONE,
+            mce_name_appeared, mce_name_vanished,
+            mce_proxy_weak_new(self, 0), mce_proxy_weak_free);
+        for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+            if (priv->ind[i].active) {
+                /* These become a part of the first resync batch */
+                mce_proxy_query(self, i);
+            }
+        }
     } else {
-        GERR("Failed to initialize MCE signal proxy: %s", GERRMSG(error));
-        g_error_free(error);
+        /* Peer-to-peer connection, there's no name to watch */
+        priv->name_known = TRUE;
+        priv->name_owned = TRUE;
+        mce_proxy_update_valid(self);
+        mce_proxy_resync(self);
     }
-    mce_proxy_unref(self);
 }
 
 static
@@ -165,44 +1005,151 @@ mce_proxy_bus_get_finished(
     MceProxy* self = MCE_PROXY(arg);
     MceProxyPriv* priv = self->priv;
     GError* error = NULL;
+    GDBusConnection* bus = g_bus_get_finish(result, &error);
 
-    priv->bus = g_bus_get_finish(result, &error);
-    if (priv->bus) {
-        com_nokia_mce_request_proxy_new(priv->bus,
-            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
-            MCE_SERVICE, MCE_REQUEST_PATH, NULL,
-            mce_proxy_request_proxy_new_finished,
-            mce_proxy_ref(self));
-        com_nokia_mce_signal_proxy_new(priv->bus,
-            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
-            MCE_SERVICE, MCE_SIGNAL_PATH, NULL,
-            mce_proxy_signal_proxy_new_finished,
-            mce_proxy_ref(self));
+    if (bus) {
+        mce_proxy_lock(self);
+        if (priv->bus) {
+            /* Shouldn't happen but let's be paranoid */
+            g_object_unref(bus);
+        } else if (g_dbus_connection_is_closed(bus)) {
+            /* Must be the old connection which hasn't been dropped yet */
+            g_object_unref(bus);
+            mce_proxy_schedule_reconnect(self);
+        } else {
+            priv->reconnect_count = 0;
+            mce_proxy_attach(self, bus);
+        }
+        mce_proxy_unlock(self);
     } else {
         GERR("Failed to attach to system bus: %s", GERRMSG(error));
         g_error_free(error);
+        mce_proxy_lock(self);
+        mce_proxy_schedule_reconnect(self);
+        mce_proxy_unlock(self);
     }
     mce_proxy_unref(self);
 }
 
+static
+gboolean
+mce_proxy_synced(
+    MceProxy* self)
+{
+    MceProxyPriv* priv = self->priv;
+    gboolean synced = FALSE;
+
+    mce_proxy_lock(self);
+    if (priv->name_known) {
+        if (priv->name_owned) {
+            int i;
+
+            synced = TRUE;
+            for (i = 0; i < MCE_PROXY_PROPERTY_COUNT && synced; i++) {
+                const MceProxyInd* ind = priv->ind + i;
+
+                /* Failed queries don't count, they won't be known */
+                if (ind->active && !ind->known &&
+                    (ind->query_pending || ind->query_scheduled)) {
+                    synced = FALSE;
+                }
+            }
+        } else {
+            /* There's no mce, nothing to wait for */
+            synced = TRUE;
+        }
+    }
+    mce_proxy_unlock(self);
+    return synced;
+}
+
+static
+gboolean
+mce_proxy_sync_timeout(
+    gpointer data)
+{
+    *((gboolean*)data) = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+static
 MceProxy*
-mce_proxy_new()
+mce_proxy_create(
+    const char* service,
+    const char* request_path,
+    const char* signal_path)
 {
+    MceProxy* self = g_object_new(MCE_PROXY_TYPE, NULL);
+    MceProxyPriv* priv = self->priv;
+
     /*
-     * Since there's only one mce in the system, there's no need for
-     * more than one proxy object.
+     * GDBus invokes the callbacks in the thread-default context of
+     * the thread which submitted the request. Timers have to be
+     * attached to the same context.
      */
-    static MceProxy* mce_proxy_instance = NULL;
-    if (mce_proxy_instance) {
-        mce_proxy_ref(mce_proxy_instance);
-    } else {
-        mce_proxy_instance = g_object_new(MCE_PROXY_TYPE, NULL);
+    priv->context = g_main_context_ref_thread_default();
+    priv->service = g_strdup(service);
+    priv->request_path = g_strdup(request_path);
+    priv->signal_path = g_strdup(signal_path);
+    return self;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceProxy*
+mce_proxy_new()
+{
+    MceProxy* self;
+
+    G_LOCK(mce_proxy_instance);
+    self = g_weak_ref_get(&mce_proxy_instance);
+    if (!self) {
+        self = mce_proxy_create(MCE_SERVICE, MCE_REQUEST_PATH,
+            MCE_SIGNAL_PATH);
+        self->priv->system_bus = TRUE;
         g_bus_get(G_BUS_TYPE_SYSTEM, NULL, mce_proxy_bus_get_finished,
-            mce_proxy_ref(mce_proxy_instance));
-        g_object_add_weak_pointer(G_OBJECT(mce_proxy_instance),
-            (gpointer*)(&mce_proxy_instance));
+            mce_proxy_ref(self));
+        g_weak_ref_set(&mce_proxy_instance, self);
     }
-    return mce_proxy_instance;
+    G_UNLOCK(mce_proxy_instance);
+    return self;
+}
+
+MceProxy*
+mce_proxy_ref_shared(
+    void)
+{
+    MceProxy* self;
+
+    G_LOCK(mce_proxy_instance);
+    self = g_weak_ref_get(&mce_proxy_instance);
+    G_UNLOCK(mce_proxy_instance);
+    return self;
+}
+
+MceProxy*
+mce_proxy_new_for_connection(
+    GDBusConnection* bus,
+    const char* service,
+    const char* request_path,
+    const char* signal_path)
+{
+    if (G_LIKELY(bus)) {
+        MceProxy* self = mce_proxy_create(
+            /* Peer-to-peer connections have no unique name */
+            g_dbus_connection_get_unique_name(bus) ?
+                (service ? service : MCE_SERVICE) : NULL,
+            request_path ? request_path : MCE_REQUEST_PATH,
+            signal_path ? signal_path : MCE_SIGNAL_PATH);
+
+        mce_proxy_lock(self);
+        mce_proxy_attach(self, g_object_ref(bus));
+        mce_proxy_unlock(self);
+        return self;
+    }
+    return NULL;
 }
 
 MceProxy*
@@ -234,6 +1181,16 @@ mce_proxy_add_valid_changed_handler(
         SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
 }
 
+gulong
+mce_proxy_add_resync_done_handler(
+    MceProxy* self,
+    MceProxyFunc fn,
+    void* arg)
+{
+    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
+        SIGNAL_RESYNC_DONE_NAME, G_CALLBACK(fn), arg) : 0;
+}
+
 void
 mce_proxy_remove_handler(
     MceProxy* self,
@@ -244,13 +1201,334 @@ mce_proxy_remove_handler(
     }
 }
 
+gboolean
+mce_proxy_sync(
+    MceProxy* self,
+    guint timeout_ms)
+{
+    gboolean ok = FALSE;
+
+    if (G_LIKELY(self)) {
+        MceProxyPriv* priv = self->priv;
+        GMainContext* context = priv->context;
+
+        if (!mce_proxy_synced(self) && timeout_ms) {
+            if (g_main_context_acquire(context)) {
+                gboolean timed_out = FALSE;
+                GSource* timer = g_timeout_source_new(timeout_ms);
+
+                /*
+                 * The replies are dispatched right here. Whatever gets
+                 * submitted in the process must end up in the same
+                 * context, hence the push.
+                 */
+                g_main_context_push_thread_default(context);
+                g_source_set_callback(timer, mce_proxy_sync_timeout,
+                    &timed_out, NULL);
+                g_source_attach(timer, context);
+                while (!timed_out && !mce_proxy_synced(self)) {
+                    g_main_context_iteration(context, TRUE);
+                }
+                g_source_destroy(timer);
+                g_source_unref(timer);
+                g_main_context_pop_thread_default(context);
+                g_main_context_release(context);
+            } else {
+                GWARN("Can't wait, the context is owned by another thread");
+            }
+        }
+        mce_proxy_lock(self);
+        if (self->valid) {
+            int i;
+
+            ok = TRUE;
+            for (i = 0; i < MCE_PROXY_PROPERTY_COUNT && ok; i++) {
+                const MceProxyInd* ind = priv->ind + i;
+
+                ok = !ind->active || ind->known;
+            }
+        }
+        mce_proxy_unlock(self);
+    }
+    return ok;
+}
+
+void
+mce_proxy_set_retry_policy(
+    MceProxy* self,
+    const MceProxyRetryPolicy* policy)
+{
+    if (G_LIKELY(self)) {
+        mce_proxy_lock(self);
+        self->priv->retry_policy = policy ? *policy :
+            mce_proxy_default_retry_policy;
+        mce_proxy_unlock(self);
+    }
+}
+
+void
+mce_proxy_set_reconnect(
+    MceProxy* self,
+    gboolean reconnect)
+{
+    if (G_LIKELY(self)) {
+        MceProxyPriv* priv = self->priv;
+
+        mce_proxy_lock(self);
+        if (priv->system_bus) {
+            priv->reconnect = reconnect;
+            if (reconnect) {
+                if (priv->bus) {
+                    g_dbus_connection_set_exit_on_close(priv->bus, FALSE);
+                } else {
+                    /* Not connected (anymore) */
+                    mce_proxy_schedule_reconnect(self);
+                }
+            } else if (priv->reconnect_timer) {
+                g_source_destroy(priv->reconnect_timer);
+                g_source_unref(priv->reconnect_timer);
+                priv->reconnect_timer = NULL;
+            }
+        }
+        mce_proxy_unlock(self);
+    }
+}
+
+void
+mce_proxy_get_stats(
+    MceProxy* self,
+    MceProxyStats* stats)
+{
+    if (G_LIKELY(stats)) {
+        if (G_LIKELY(self)) {
+            mce_proxy_lock(self);
+            *stats = self->priv->stats;
+            mce_proxy_unlock(self);
+        } else {
+            memset(stats, 0, sizeof(*stats));
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gulong
+mce_proxy_add_signal_handler(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property,
+    MceProxySignalFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn) &&
+        G_LIKELY(property < MCE_PROXY_PROPERTY_COUNT)) {
+        MceProxyPriv* priv = self->priv;
+        MceProxyInd* ind = priv->ind + property;
+        MceProxySignalHandler* handler;
+        gulong id;
+
+        mce_proxy_lock(self);
+        ind->handlers = g_renew(MceProxySignalHandler, ind->handlers,
+            ind->count + 1);
+        handler = ind->handlers + (ind->count++);
+        id = handler->id = ++priv->last_signal_handler_id;
+        handler->fn = fn;
+        handler->arg = arg;
+        handler->fresh = FALSE;
+        ind->active++;
+        if (ind->known) {
+            /*
+             * The current value is already known, no need to ask mce
+             * again. The new handler gets the cached one from the
+             * proxy's context.
+             */
+            handler->fresh = TRUE;
+            mce_proxy_kick(self);
+        } else if (mce_proxy_in_context(self)) {
+            if (ind->active == 1 && priv->bus) {
+                mce_proxy_subscribe(self, property);
+            }
+            /* The new handler needs to know the current value */
+            mce_proxy_query(self, property);
+        } else {
+            /*
+             * GDBus would deliver the replies and signals to the
+             * context of this thread. Let the proxy's own context
+             * take care of that.
+             */
+            ind->query_scheduled = TRUE;
+            mce_proxy_kick(self);
+        }
+        mce_proxy_unlock(self);
+        return id;
+    }
+    return 0;
+}
+
+void
+mce_proxy_remove_signal_handler(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id) &&
+        G_LIKELY(property < MCE_PROXY_PROPERTY_COUNT)) {
+        MceProxyInd* ind = self->priv->ind + property;
+        guint i;
+
+        mce_proxy_lock(self);
+        for (i = 0; i < ind->count; i++) {
+            MceProxySignalHandler* handler = ind->handlers + i;
+
+            if (handler->id == id && handler->fn) {
+                handler->fn = NULL;
+                if (!ind->dispatching) {
+                    mce_proxy_ind_compact(ind);
+                }
+                if (!--ind->active) {
+                    /* Nobody needs this signal anymore */
+                    mce_proxy_unsubscribe(self, property);
+                    mce_proxy_cancel_retry(ind);
+                    ind->known = FALSE;
+                    mce_residency_leave(self->priv->residency + property,
+                        mce_clock_boottime());
+                    mce_proxy_resync_done(self, property);
+                }
+                break;
+            }
+        }
+        mce_proxy_unlock(self);
+    }
+}
+
+MceProxy*
+mce_proxy_new_detached()
+{
+    MceProxy* self = mce_proxy_create(NULL, MCE_REQUEST_PATH,
+        MCE_SIGNAL_PATH);
+    MceProxyPriv* priv = self->priv;
+
+    /* There's no bus, the values are injected from outside */
+    priv->name_known = TRUE;
+    priv->name_owned = TRUE;
+    self->valid = TRUE;
+    return self;
+}
+
+void
+mce_proxy_inject(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property,
+    const MceProxyValue* value)
+{
+    if (G_LIKELY(self) && G_LIKELY(property < MCE_PROXY_PROPERTY_COUNT)) {
+        mce_proxy_lock(self);
+        mce_proxy_ind_dispatch(self->priv->ind + property, value);
+        mce_proxy_unlock(self);
+    }
+}
+
+gboolean
+mce_proxy_set_tap(
+    MceProxy* self,
+    MceProxyTapFunc fn,
+    void* arg)
+{
+    MceProxyPriv* priv = self->priv;
+    gboolean ok = TRUE;
+
+    mce_proxy_lock(self);
+    if (fn) {
+        if (priv->tap) {
+            ok = FALSE;
+        } else {
+            priv->tap = fn;
+            priv->tap_arg = arg;
+        }
+    } else if (priv->tap_arg == arg) {
+        priv->tap = NULL;
+        priv->tap_arg = NULL;
+    } else {
+        ok = FALSE;
+    }
+    mce_proxy_unlock(self);
+    return ok;
+}
+
+void
+mce_proxy_lock(
+    MceProxy* self)
+{
+    g_rec_mutex_lock(&self->priv->mutex);
+}
+
+void
+mce_proxy_unlock(
+    MceProxy* self)
+{
+    g_rec_mutex_unlock(&self->priv->mutex);
+}
+
+GMainContext*
+mce_proxy_context(
+    MceProxy* self)
+{
+    return self->priv->context;
+}
+
+MceResidencyCounter*
+mce_proxy_residency(
+    MceProxy* self,
+    MCE_PROXY_PROPERTY property)
+{
+    return self->priv->residency + property;
+}
+
+gpointer
+mce_proxy_object_ref(
+    MceProxy* self,
+    MCE_PROXY_OBJECT type)
+{
+    return (G_LIKELY(self) && G_LIKELY(type < MCE_PROXY_OBJECT_COUNT)) ?
+        g_weak_ref_get(self->priv->object + type) : NULL;
+}
+
+void
+mce_proxy_object_set(
+    MceProxy* self,
+    MCE_PROXY_OBJECT type,
+    gpointer object)
+{
+    if (G_LIKELY(self) && G_LIKELY(type < MCE_PROXY_OBJECT_COUNT)) {
+        /* The reference gets cleared when the object is finalized */
+        g_weak_ref_set(self->priv->object + type, object);
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
 static
 void
 mce_proxy_init(
     MceProxy* self)
 {
-    self->priv = G_TYPE_INSTANCE_GET_PRIVATE(self,
+    MceProxyPriv* priv = G_TYPE_INSTANCE_GET_PRIVATE(self,
         MCE_PROXY_TYPE, MceProxyPriv);
+    int i;
+
+    self->priv = priv;
+    g_rec_mutex_init(&priv->mutex);
+    priv->cancellable = g_cancellable_new();
+    priv->retry_policy = mce_proxy_default_retry_policy;
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        priv->ind[i].proxy = self;
+    }
+    for (i = 0; i < MCE_PROXY_OBJECT_COUNT; i++) {
+        g_weak_ref_init(priv->object + i, NULL);
+    }
 }
 
 static
@@ -260,19 +1538,30 @@ mce_proxy_finalize(
 {
     MceProxy* self = MCE_PROXY(object);
     MceProxyPriv* priv = self->priv;
+    int i;
 
-    if (priv->mce_watch_id) {
-        g_bus_unwatch_name(priv->mce_watch_id);
+    if (priv->bus) {
+        mce_proxy_detach(self);
     }
-    if (self->signal) {
-        g_object_unref(self->signal);
+    if (priv->reconnect_timer) {
+        g_source_destroy(priv->reconnect_timer);
+        g_source_unref(priv->reconnect_timer);
     }
-    if (self->request) {
-        g_object_unref(self->request);
+    g_cancellable_cancel(priv->cancellable);
+    g_object_unref(priv->cancellable);
+    for (i = 0; i < MCE_PROXY_PROPERTY_COUNT; i++) {
+        mce_proxy_cancel_retry(priv->ind + i);
+        g_free(priv->ind[i].handlers);
+        g_free(priv->ind[i].str);
     }
-    if (priv->bus) {
-        g_object_unref(priv->bus);
+    for (i = 0; i < MCE_PROXY_OBJECT_COUNT; i++) {
+        g_weak_ref_clear(priv->object + i);
     }
+    g_rec_mutex_clear(&priv->mutex);
+    g_main_context_unref(priv->context);
+    g_free(priv->service);
+    g_free(priv->request_path);
+    g_free(priv->signal_path);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -282,12 +1571,17 @@ mce_proxy_class_init(
     MceProxyClass* klass)
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
     object_class->finalize = mce_proxy_finalize;
     g_type_class_add_private(klass, sizeof(MceProxyPriv));
     mce_proxy_signals[SIGNAL_VALID_CHANGED] =
         g_signal_new(SIGNAL_VALID_CHANGED_NAME,
             G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
             0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    mce_proxy_signals[SIGNAL_RESYNC_DONE] =
+        g_signal_new(SIGNAL_RESYNC_DONE_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 0);
 }
 
 /*
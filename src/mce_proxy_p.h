@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2016-2022 Jolla Ltd.
+ * Copyright (C) 2016-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_PROXY_PRIVATE_H
+#define MCE_PROXY_PRIVATE_H
+
+#include "mce_types_p.h"
+#include "mce_residency_p.h"
+#include "mce_proxy.h"
+
+/*
+ * State that can be queried from mce and is broadcast when it changes.
+ * The values are stored in the recordings, don't reorder.
+ */
+typedef enum mce_proxy_property {
+    MCE_PROXY_DISPLAY_STATUS,
+    MCE_PROXY_TKLOCK_MODE,
+    MCE_PROXY_BATTERY_LEVEL,
+    MCE_PROXY_BATTERY_STATUS,
+    MCE_PROXY_CHARGER_STATE,
+    MCE_PROXY_INACTIVITY_STATUS,
+    MCE_PROXY_PROPERTY_COUNT
+} MCE_PROXY_PROPERTY;
+
+/*
+ * Objects of which there's only one per proxy. The eager ones are
+ * returned by mce_xxx_new() and track the state for as long as they
+ * exist, the lazy ones (mce_xxx_new_for_proxy) only while needed.
+ */
+typedef enum mce_proxy_object {
+    MCE_PROXY_OBJECT_BATTERY,
+    MCE_PROXY_OBJECT_BATTERY_EAGER,
+    MCE_PROXY_OBJECT_BATTERY_ESTIMATOR,
+    MCE_PROXY_OBJECT_CHARGER,
+    MCE_PROXY_OBJECT_CHARGER_EAGER,
+    MCE_PROXY_OBJECT_DISPLAY,
+    MCE_PROXY_OBJECT_DISPLAY_EAGER,
+    MCE_PROXY_OBJECT_INACTIVITY,
+    MCE_PROXY_OBJECT_INACTIVITY_EAGER,
+    MCE_PROXY_OBJECT_STATE,
+    MCE_PROXY_OBJECT_TKLOCK,
+    MCE_PROXY_OBJECT_TKLOCK_EAGER,
+    MCE_PROXY_OBJECT_COUNT
+} MCE_PROXY_OBJECT;
+
+/*
+ * Decoded value, the member is determined by the property type.
+ * Strings are borrowed from the D-Bus message and are only valid
+ * for the duration of the callback. The time is CLOCK_BOOTTIME
+ * (in microseconds) at which the message was decoded.
+ */
+typedef struct mce_proxy_value {
+    gint64 time;
+    const char* str;
+    gint32 i;
+    gboolean b;
+} MceProxyValue;
+
+typedef void
+(*MceProxySignalFunc)(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg);
+
+/* Sees every decoded value before the handlers do */
+typedef void
+(*MceProxyTapFunc)(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    const MceProxyValue* value,
+    void* arg);
+
+/*
+ * The match rule for the signal is only installed while there's
+ * at least one handler for it. The handlers receive both the signal
+ * payload and the query replies. Adding a handler triggers a query
+ * for the current value (unless one is already in flight).
+ */
+gulong
+mce_proxy_add_signal_handler(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    MceProxySignalFunc fn,
+    void* arg)
+    MCE_INTERNAL;
+
+void
+mce_proxy_remove_signal_handler(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    gulong id)
+    MCE_INTERNAL;
+
+/*
+ * A detached proxy has no D-Bus connection and is always valid. The
+ * values are fed into it with mce_proxy_inject() and get dispatched
+ * to the handlers exactly as if they had been received from mce.
+ */
+MceProxy*
+mce_proxy_new_detached(
+    void)
+    MCE_INTERNAL;
+
+/* Returns the shared proxy if it exists, without creating one */
+MceProxy*
+mce_proxy_ref_shared(
+    void)
+    MCE_INTERNAL;
+
+void
+mce_proxy_inject(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    const MceProxyValue* value)
+    MCE_INTERNAL;
+
+/*
+ * Only one tap at a time, returns FALSE if another one is already
+ * installed. NULL fn removes the tap which was installed with the
+ * same arg.
+ */
+gboolean
+mce_proxy_set_tap(
+    MceProxy* proxy,
+    MceProxyTapFunc fn,
+    void* arg)
+    MCE_INTERNAL;
+
+/*
+ * The lock is recursive. Everything attached to the proxy (including
+ * the objects below) is protected by it.
+ */
+void
+mce_proxy_lock(
+    MceProxy* proxy)
+    MCE_INTERNAL;
+
+void
+mce_proxy_unlock(
+    MceProxy* proxy)
+    MCE_INTERNAL;
+
+/* The context where the state gets updated */
+GMainContext*
+mce_proxy_context(
+    MceProxy* proxy)
+    MCE_INTERNAL;
+
+/* Per property, must be used under the lock */
+MceResidencyCounter*
+mce_proxy_residency(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property)
+    MCE_INTERNAL;
+
+/* These two must be called under the lock */
+gpointer
+mce_proxy_object_ref(
+    MceProxy* proxy,
+    MCE_PROXY_OBJECT type)
+    MCE_INTERNAL;
+
+void
+mce_proxy_object_set(
+    MceProxy* proxy,
+    MCE_PROXY_OBJECT type,
+    gpointer object)
+    MCE_INTERNAL;
+
+#endif /* MCE_PROXY_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef MCE_RECORD_PRIVATE_H
+#define MCE_RECORD_PRIVATE_H
+
+#include "mce_types_p.h"
+
+/*
+ * Recording file format. The header is followed by the records, all
+ * in host byte order. The records are properly aligned for reading
+ * straight from a memory-mapped file.
+ */
+
+#define MCE_RECORD_MAGIC "MCEREC01"
+#define MCE_RECORD_MAGIC_LEN (8)
+#define MCE_RECORD_STR_SIZE (20)
+
+typedef struct mce_record_header {
+    char magic[MCE_RECORD_MAGIC_LEN];
+    guint32 record_size;
+    guint32 reserved;
+} MceRecordHeader;
+
+typedef struct mce_record {
+    gint64 time;                /* CLOCK_BOOTTIME, microseconds */
+    guint32 property;           /* MCE_PROXY_PROPERTY */
+    gint32 i;
+    gint32 b;
+    char str[MCE_RECORD_STR_SIZE]; /* NUL-terminated, may be truncated */
+} MceRecord;
+
+G_STATIC_ASSERT(sizeof(MceRecordHeader) == 16);
+G_STATIC_ASSERT(sizeof(MceRecord) == 40);
+
+#endif /* MCE_RECORD_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_recorder.h"
+#include "mce_record_p.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * The tap is invoked under the proxy lock, on the thread dispatching
+ * the updates. It only appends the record to the queue, the file is
+ * written by a separate thread.
+ */
+struct mce_recorder {
+    MceProxy* proxy;
+    int fd;
+    GThread* thread;
+    GMutex mutex;
+    GCond cond;
+    GByteArray* queue;          /* Protected by the mutex */
+    GByteArray* spare;          /* NULL while being written */
+    gboolean stop;
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+gboolean
+mce_recorder_write(
+    int fd,
+    const void* data,
+    gsize size)
+{
+    const char* ptr = data;
+
+    while (size > 0) {
+        const gssize written = write(fd, ptr, size);
+
+        if (written < 0) {
+            if (errno != EINTR) {
+                return FALSE;
+            }
+        } else {
+            ptr += written;
+            size -= written;
+        }
+    }
+    return TRUE;
+}
+
+static
+gpointer
+mce_recorder_thread(
+    gpointer data)
+{
+    MceRecorder* self = data;
+
+    g_mutex_lock(&self->mutex);
+    for (;;) {
+        GByteArray* out;
+
+        while (!self->queue->len && !self->stop) {
+            g_cond_wait(&self->cond, &self->mutex);
+        }
+        if (!self->queue->len) {
+            /* Stopped and everything has been written */
+            break;
+        }
+        out = self->queue;
+        self->queue = self->spare;
+        self->spare = NULL;
+        g_mutex_unlock(&self->mutex);
+        if (!mce_recorder_write(self->fd, out->data, out->len)) {
+            GWARN("Failed to record: %s", strerror(errno));
+        }
+        g_byte_array_set_size(out, 0);
+        g_mutex_lock(&self->mutex);
+        self->spare = out;
+    }
+    g_mutex_unlock(&self->mutex);
+    return NULL;
+}
+
+static
+void
+mce_recorder_tap(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    const MceProxyValue* value,
+    void* arg)
+{
+    MceRecorder* self = arg;
+    MceRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.time = value->time;
+    record.property = property;
+    record.i = value->i;
+    record.b = value->b;
+    if (value->str) {
+        g_strlcpy(record.str, value->str, sizeof(record.str));
+    }
+    g_mutex_lock(&self->mutex);
+    g_byte_array_append(self->queue, (const guint8*)&record, sizeof(record));
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->mutex);
+}
+
+static
+void
+mce_recorder_destroy(
+    MceRecorder* self)
+{
+    g_byte_array_unref(self->queue);
+    if (self->spare) {
+        g_byte_array_unref(self->spare);
+    }
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->mutex);
+    mce_proxy_unref(self->proxy);
+    g_slice_free(MceRecorder, self);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceRecorder*
+mce_recorder_new(
+    MceProxy* proxy,
+    const char* path,
+    GError** error)
+{
+    if (G_LIKELY(proxy) && G_LIKELY(path)) {
+        MceRecorder* self = g_slice_new0(MceRecorder);
+        MceRecordHeader header;
+        int fd;
+
+        self->proxy = mce_proxy_ref(proxy);
+        self->queue = g_byte_array_new();
+        self->spare = g_byte_array_new();
+        g_mutex_init(&self->mutex);
+        g_cond_init(&self->cond);
+
+        /* Claim the tap before touching the file */
+        if (!mce_proxy_set_tap(proxy, mce_recorder_tap, self)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_BUSY,
+                "The proxy is already being recorded");
+            mce_recorder_destroy(self);
+            return NULL;
+        }
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MCE_RECORD_MAGIC, MCE_RECORD_MAGIC_LEN);
+        header.record_size = sizeof(MceRecord);
+        fd = g_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0 && mce_recorder_write(fd, &header, sizeof(header))) {
+            /* Whatever has been queued so far gets written right away */
+            self->fd = fd;
+            self->thread = g_thread_new("mce-recorder",
+                mce_recorder_thread, self);
+            return self;
+        }
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+            "%s: %s", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        mce_proxy_set_tap(proxy, NULL, self);
+        mce_recorder_destroy(self);
+    }
+    return NULL;
+}
+
+void
+mce_recorder_free(
+    MceRecorder* self)
+{
+    if (G_LIKELY(self)) {
+        mce_proxy_set_tap(self->proxy, NULL, self);
+        g_mutex_lock(&self->mutex);
+        self->stop = TRUE;
+        g_cond_signal(&self->cond);
+        g_mutex_unlock(&self->mutex);
+
+        /* The thread writes everything that's left before exiting */
+        g_thread_join(self->thread);
+        close(self->fd);
+        mce_recorder_destroy(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
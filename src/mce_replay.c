@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_recorder.h"
+#include "mce_record_p.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+#include <string.h>
+
+struct mce_replay {
+    GMappedFile* map;
+    const MceRecord* records;
+    guint count;
+    guint pos;
+    MceProxy* proxy;
+    GMainContext* context;
+    GSource* timer;
+    MceReplayFunc done;
+    void* done_arg;
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_replay_dispatch(
+    MceReplay* self,
+    const MceRecord* record)
+{
+    MceProxyValue value;
+
+    memset(&value, 0, sizeof(value));
+    value.time = record->time;
+    value.i = record->i;
+    value.b = record->b;
+    if (record->str[0]) {
+        value.str = record->str;
+    }
+    mce_proxy_inject(self->proxy, record->property, &value);
+}
+
+static
+void
+mce_replay_schedule(
+    MceReplay* self);
+
+static
+gboolean
+mce_replay_timeout(
+    gpointer data)
+{
+    MceReplay* self = data;
+
+    g_source_unref(self->timer);
+    self->timer = NULL;
+    mce_replay_step(self);
+    mce_replay_schedule(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_replay_schedule(
+    MceReplay* self)
+{
+    if (self->pos < self->count) {
+        const MceRecord* next = self->records + self->pos;
+        const gint64 delay = self->pos ?
+            (next->time - next[-1].time) / 1000 : 0;
+
+        self->timer = g_timeout_source_new((guint)CLAMP(delay, 0,
+            G_MAXUINT));
+        g_source_set_callback(self->timer, mce_replay_timeout, self, NULL);
+        g_source_attach(self->timer, self->context);
+    } else if (self->done) {
+        MceReplayFunc done = self->done;
+
+        self->done = NULL;
+        done(self, self->done_arg);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceReplay*
+mce_replay_new(
+    const char* path,
+    GError** error)
+{
+    if (G_LIKELY(path)) {
+        GMappedFile* map = g_mapped_file_new(path, FALSE, error);
+
+        if (map) {
+            const gsize size = g_mapped_file_get_length(map);
+            const char* data = g_mapped_file_get_contents(map);
+            const MceRecordHeader* header = (const MceRecordHeader*)data;
+
+            if (size >= sizeof(*header) &&
+                !memcmp(header->magic, MCE_RECORD_MAGIC,
+                    MCE_RECORD_MAGIC_LEN) &&
+                header->record_size == sizeof(MceRecord)) {
+                MceReplay* self = g_slice_new0(MceReplay);
+
+                self->map = map;
+                self->records = (const MceRecord*)(header + 1);
+                self->count = (size - sizeof(*header)) / sizeof(MceRecord);
+                self->proxy = mce_proxy_new_detached();
+                self->context = g_main_context_ref_thread_default();
+                return self;
+            }
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                "%s: not a recording", path);
+            g_mapped_file_unref(map);
+        }
+    }
+    return NULL;
+}
+
+void
+mce_replay_free(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        mce_replay_stop(self);
+        mce_proxy_unref(self->proxy);
+        g_main_context_unref(self->context);
+        g_mapped_file_unref(self->map);
+        g_slice_free(MceReplay, self);
+    }
+}
+
+MceProxy*
+mce_replay_proxy(
+    MceReplay* self)
+{
+    return G_LIKELY(self) ? self->proxy : NULL;
+}
+
+guint
+mce_replay_count(
+    MceReplay* self)
+{
+    return G_LIKELY(self) ? self->count : 0;
+}
+
+gboolean
+mce_replay_step(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        while (self->pos < self->count) {
+            const MceRecord* record = self->records + (self->pos++);
+
+            if (record->property < MCE_PROXY_PROPERTY_COUNT &&
+                !record->str[MCE_RECORD_STR_SIZE - 1]) {
+                mce_replay_dispatch(self, record);
+                return TRUE;
+            }
+            GWARN("Skipping invalid record #%u", self->pos - 1);
+        }
+    }
+    return FALSE;
+}
+
+guint
+mce_replay_run(
+    MceReplay* self)
+{
+    guint n = 0;
+
+    while (mce_replay_step(self)) {
+        n++;
+    }
+    return n;
+}
+
+void
+mce_replay_play(
+    MceReplay* self,
+    MceReplayFunc done,
+    void* arg)
+{
+    if (G_LIKELY(self)) {
+        mce_replay_stop(self);
+        self->done = done;
+        self->done_arg = arg;
+        mce_replay_schedule(self);
+    }
+}
+
+void
+mce_replay_stop(
+    MceReplay* self)
+{
+    if (G_LIKELY(self)) {
+        if (self->timer) {
+            g_source_destroy(self->timer);
+            g_source_unref(self->timer);
+            self->timer = NULL;
+        }
+        self->done = NULL;
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
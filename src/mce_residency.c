@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_residency.h"
+#include "mce_residency_p.h"
+#include "mce_clock_p.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+#include <string.h>
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_residency_flush(
+    MceResidencyCounter* counter,
+    gint64 time)
+{
+    if (counter->since) {
+        /* The time stamp may be a bit older than the last flush */
+        if (time > counter->since) {
+            const gint64 dt = time - counter->since;
+
+            counter->total[counter->state] += dt;
+            counter->window[counter->state] += dt;
+            counter->since = time;
+        }
+    }
+}
+
+static
+void
+mce_residency_read(
+    MceResidencyCounter* counter,
+    gint64 now,
+    gint64* total,
+    gint64* window,
+    guint count,
+    gboolean reset_window)
+{
+    GASSERT(count <= MCE_RESIDENCY_MAX_STATES);
+    mce_residency_flush(counter, now);
+    memcpy(total, counter->total, sizeof(total[0]) * count);
+    memcpy(window, counter->window, sizeof(window[0]) * count);
+    if (reset_window) {
+        memset(counter->window, 0, sizeof(counter->window));
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+void
+mce_residency_enter(
+    MceResidencyCounter* counter,
+    int state,
+    gint64 time)
+{
+    if (state >= 0 && state < MCE_RESIDENCY_MAX_STATES) {
+        mce_residency_flush(counter, time);
+        if (!counter->since) {
+            counter->since = time;
+        }
+        counter->state = state;
+    }
+}
+
+void
+mce_residency_leave(
+    MceResidencyCounter* counter,
+    gint64 time)
+{
+    mce_residency_flush(counter, time);
+    counter->since = 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+mce_residency_snapshot(
+    MceProxy* proxy,
+    MceResidency* out,
+    gboolean reset_window)
+{
+    if (G_LIKELY(out)) {
+        /* A proxy which doesn't exist hasn't been tracking anything */
+        MceProxy* p = proxy ? mce_proxy_ref(proxy) : mce_proxy_ref_shared();
+        const gint64 now = mce_clock_boottime();
+
+        memset(out, 0, sizeof(*out));
+        out->time = now;
+        if (p) {
+            mce_proxy_lock(p);
+#define MCE_RESIDENCY_READ(prop,field) \
+            mce_residency_read(mce_proxy_residency(p, prop), now, \
+                out->total.field, out->window.field, \
+                G_N_ELEMENTS(out->total.field), reset_window)
+            MCE_RESIDENCY_READ(MCE_PROXY_DISPLAY_STATUS, display);
+            MCE_RESIDENCY_READ(MCE_PROXY_TKLOCK_MODE, tklock);
+            MCE_RESIDENCY_READ(MCE_PROXY_CHARGER_STATE, charger);
+            MCE_RESIDENCY_READ(MCE_PROXY_INACTIVITY_STATUS, inactivity);
+#undef MCE_RESIDENCY_READ
+            mce_proxy_unlock(p);
+            mce_proxy_unref(p);
+        }
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,603 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_scheduler.h"
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_proxy.h"
+#include "mce_clock_p.h"
+#include "mce_log_p.h"
+
+#include <string.h>
+
+#define MCE_SCHEDULER_BATTERY_NEVER (101)
+
+/*
+ * GLib timeouts are based on the monotonic clock which stops while
+ * the device is suspended. Deadlines are checked against the boot
+ * time at least this often, which limits how late they can be.
+ */
+#define MCE_SCHEDULER_TIMER_MAX_MS (60000)
+
+typedef enum mce_scheduler_job_state {
+    MCE_SCHEDULER_JOB_PENDING,
+    MCE_SCHEDULER_JOB_RUNNING,
+    MCE_SCHEDULER_JOB_FORCED    /* Not to be preempted */
+} MCE_SCHEDULER_JOB_STATE;
+
+typedef struct mce_scheduler_job {
+    guint id;
+    int priority;
+    gint64 deadline;            /* CLOCK_BOOTTIME, microseconds */
+    MCE_SCHEDULER_JOB_STATE state;
+    MceSchedulerJobFunc run;
+    MceSchedulerJobFunc preempt;
+    void* arg;
+    GDestroyNotify destroy;
+} MceSchedulerJob;
+
+struct mce_scheduler {
+    MceProxy* proxy;
+    GMainContext* context;
+    GPtrArray* jobs;            /* Sorted by priority, FIFO within */
+    guint last_id;
+    guint battery_level;
+    gint64 batch_window;        /* Microseconds */
+    gboolean favorable;
+    GSource* update;
+    GSource* timer;
+    MceBattery* battery;
+    MceCharger* charger;
+    MceDisplay* display;
+    MceInactivity* inactivity;
+    gulong battery_id[2];
+    gulong charger_id[2];
+    gulong display_id[2];
+    gulong inactivity_id[2];
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_scheduler_job_free(
+    MceSchedulerJob* job)
+{
+    if (job->destroy) {
+        job->destroy(job->arg);
+    }
+    g_slice_free(MceSchedulerJob, job);
+}
+
+static
+int
+mce_scheduler_job_index(
+    MceScheduler* self,
+    guint id)
+{
+    guint i;
+
+    for (i = 0; i < self->jobs->len; i++) {
+        const MceSchedulerJob* job = self->jobs->pdata[i];
+
+        if (job->id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static
+MceSchedulerJob*
+mce_scheduler_job_find(
+    MceScheduler* self,
+    guint id)
+{
+    const int i = mce_scheduler_job_index(self, id);
+
+    return (i >= 0) ? self->jobs->pdata[i] : NULL;
+}
+
+static
+gboolean
+mce_scheduler_remove_job(
+    MceScheduler* self,
+    guint id)
+{
+    const int i = mce_scheduler_job_index(self, id);
+
+    if (i >= 0) {
+        /* Destroy callback may call back into the scheduler */
+        MceSchedulerJob* job = g_ptr_array_remove_index(self->jobs, i);
+
+        mce_scheduler_job_free(job);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+mce_scheduler_check(
+    MceScheduler* self)
+{
+    const MceBattery* battery = self->battery;
+    const MceCharger* charger = self->charger;
+    const MceDisplay* display = self->display;
+    const MceInactivity* inactivity = self->inactivity;
+
+    return display->valid && display->state == MCE_DISPLAY_STATE_OFF &&
+        inactivity->valid && inactivity->status &&
+        charger->valid && (charger->state == MCE_CHARGER_ON ||
+            (battery && battery->valid &&
+                battery->level >= self->battery_level));
+}
+
+static
+gint64
+mce_scheduler_due_limit(
+    MceScheduler* self,
+    gint64 now)
+{
+    guint i;
+
+    /*
+     * The batch window only applies if at least one deadline has
+     * actually expired. Otherwise nothing is due.
+     */
+    for (i = 0; i < self->jobs->len; i++) {
+        const MceSchedulerJob* job = self->jobs->pdata[i];
+
+        if (job->state == MCE_SCHEDULER_JOB_PENDING && job->deadline &&
+            job->deadline <= now) {
+            return now + self->batch_window;
+        }
+    }
+    return 0;
+}
+
+static
+MceSchedulerJob*
+mce_scheduler_next(
+    MceScheduler* self,
+    gint64 limit)
+{
+    guint i;
+
+    for (i = 0; i < self->jobs->len; i++) {
+        MceSchedulerJob* job = self->jobs->pdata[i];
+
+        if (job->state == MCE_SCHEDULER_JOB_PENDING &&
+            (self->favorable || (job->deadline && job->deadline <= limit))) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+mce_scheduler_preempt(
+    MceScheduler* self)
+{
+    const guint n = self->jobs->len;
+    guint* ids = g_new(guint, n);
+    guint i, count = 0;
+
+    /* Callbacks may add and remove jobs, go by ids */
+    for (i = 0; i < n; i++) {
+        const MceSchedulerJob* job = self->jobs->pdata[i];
+
+        if (job->state == MCE_SCHEDULER_JOB_RUNNING && job->preempt) {
+            ids[count++] = job->id;
+        }
+    }
+    for (i = 0; i < count && !self->favorable; i++) {
+        MceSchedulerJob* job = mce_scheduler_job_find(self, ids[i]);
+
+        if (job && job->state == MCE_SCHEDULER_JOB_RUNNING) {
+            const gboolean stop = job->preempt(self, job->id, job->arg);
+
+            /* The preempt callback may have removed the job */
+            job = mce_scheduler_job_find(self, ids[i]);
+            if (job) {
+                if (stop) {
+                    GDEBUG("Job %u preempted", job->id);
+                    job->state = MCE_SCHEDULER_JOB_PENDING;
+                } else {
+                    /* Don't ask again */
+                    job->state = MCE_SCHEDULER_JOB_FORCED;
+                }
+            }
+        }
+    }
+    g_free(ids);
+}
+
+static
+gboolean
+mce_scheduler_timer_cb(
+    gpointer data);
+
+static
+void
+mce_scheduler_arm_timer(
+    MceScheduler* self)
+{
+    gint64 deadline = 0;
+    guint i;
+
+    for (i = 0; i < self->jobs->len; i++) {
+        const MceSchedulerJob* job = self->jobs->pdata[i];
+
+        if (job->state == MCE_SCHEDULER_JOB_PENDING && job->deadline &&
+            (!deadline || job->deadline < deadline)) {
+            deadline = job->deadline;
+        }
+    }
+
+    if (self->timer) {
+        g_source_destroy(self->timer);
+        g_source_unref(self->timer);
+        self->timer = NULL;
+    }
+
+    if (deadline) {
+        const gint64 delay = deadline - mce_clock_boottime();
+
+        /* Round up, firing early would just re-arm the timer */
+        self->timer = g_timeout_source_new(delay > 0 ?
+            (guint)MIN((delay + 999) / 1000, MCE_SCHEDULER_TIMER_MAX_MS) :
+            0);
+        g_source_set_callback(self->timer, mce_scheduler_timer_cb,
+            self, NULL);
+        g_source_attach(self->timer, self->context);
+    }
+}
+
+static
+void
+mce_scheduler_run(
+    MceScheduler* self)
+{
+    const gint64 limit = mce_scheduler_due_limit(self, mce_clock_boottime());
+    MceSchedulerJob* job;
+
+    self->favorable = mce_scheduler_check(self);
+    if (!self->favorable) {
+        mce_scheduler_preempt(self);
+    }
+
+    /* The whole batch is started within this iteration */
+    while ((job = mce_scheduler_next(self, limit)) != NULL) {
+        const guint id = job->id;
+
+        GDEBUG("Starting job %u%s", id, self->favorable ? "" :
+            " (deadline)");
+        job->state = self->favorable ? MCE_SCHEDULER_JOB_RUNNING :
+            MCE_SCHEDULER_JOB_FORCED;
+        if (job->run(self, id, job->arg)) {
+            mce_scheduler_remove_job(self, id);
+        }
+    }
+    mce_scheduler_arm_timer(self);
+}
+
+static
+gboolean
+mce_scheduler_update_cb(
+    gpointer data)
+{
+    MceScheduler* self = data;
+
+    g_source_unref(self->update);
+    self->update = NULL;
+    mce_scheduler_run(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_scheduler_schedule(
+    MceScheduler* self)
+{
+    if (!self->update) {
+        self->update = g_idle_source_new();
+        g_source_set_callback(self->update, mce_scheduler_update_cb,
+            self, NULL);
+        g_source_attach(self->update, self->context);
+    }
+}
+
+static
+gboolean
+mce_scheduler_timer_cb(
+    gpointer data)
+{
+    MceScheduler* self = data;
+
+    g_source_unref(self->timer);
+    self->timer = NULL;
+    mce_scheduler_run(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_scheduler_changed(
+    MceScheduler* self)
+{
+    const gboolean favorable = mce_scheduler_check(self);
+
+    if (self->favorable != favorable) {
+        GDEBUG("Conditions are %sfavorable", favorable ? "" : "not ");
+        self->favorable = favorable;
+        mce_scheduler_schedule(self);
+    }
+}
+
+static
+void
+mce_scheduler_battery_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    mce_scheduler_changed(arg);
+}
+
+static
+void
+mce_scheduler_charger_changed(
+    MceCharger* charger,
+    void* arg)
+{
+    mce_scheduler_changed(arg);
+}
+
+static
+void
+mce_scheduler_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    mce_scheduler_changed(arg);
+}
+
+static
+void
+mce_scheduler_inactivity_changed(
+    MceInactivity* inactivity,
+    void* arg)
+{
+    mce_scheduler_changed(arg);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceScheduler*
+mce_scheduler_new(
+    MceProxy* proxy)
+{
+    if (G_LIKELY(proxy)) {
+        MceScheduler* self = g_slice_new0(MceScheduler);
+
+        self->proxy = mce_proxy_ref(proxy);
+        self->context = g_main_context_ref_thread_default();
+        self->jobs = g_ptr_array_new();
+        self->battery_level = MCE_SCHEDULER_BATTERY_NEVER;
+        self->charger = mce_charger_new_for_proxy(proxy);
+        self->display = mce_display_new_for_proxy(proxy);
+        self->inactivity = mce_inactivity_new_for_proxy(proxy);
+        self->charger_id[0] = mce_charger_add_valid_changed_handler_in_context(
+            self->charger, mce_scheduler_charger_changed, self);
+        self->charger_id[1] = mce_charger_add_state_changed_handler_in_context(
+            self->charger, mce_scheduler_charger_changed, self);
+        self->display_id[0] = mce_display_add_valid_changed_handler_in_context(
+            self->display, mce_scheduler_display_changed, self);
+        self->display_id[1] = mce_display_add_state_changed_handler_in_context(
+            self->display, mce_scheduler_display_changed, self);
+        self->inactivity_id[0] =
+            mce_inactivity_add_valid_changed_handler_in_context(
+                self->inactivity, mce_scheduler_inactivity_changed, self);
+        self->inactivity_id[1] =
+            mce_inactivity_add_status_changed_handler_in_context(
+                self->inactivity, mce_scheduler_inactivity_changed, self);
+        self->favorable = mce_scheduler_check(self);
+        return self;
+    }
+    return NULL;
+}
+
+void
+mce_scheduler_free(
+    MceScheduler* self)
+{
+    if (G_LIKELY(self)) {
+        mce_scheduler_set_battery_level(self, MCE_SCHEDULER_BATTERY_NEVER);
+        mce_charger_remove_all_handlers(self->charger, self->charger_id);
+        mce_display_remove_all_handlers(self->display, self->display_id);
+        mce_inactivity_remove_all_handlers(self->inactivity,
+            self->inactivity_id);
+        mce_charger_unref(self->charger);
+        mce_display_unref(self->display);
+        mce_inactivity_unref(self->inactivity);
+        if (self->update) {
+            g_source_destroy(self->update);
+            g_source_unref(self->update);
+        }
+        if (self->timer) {
+            g_source_destroy(self->timer);
+            g_source_unref(self->timer);
+        }
+        while (self->jobs->len) {
+            mce_scheduler_job_free(g_ptr_array_remove_index(self->jobs,
+                self->jobs->len - 1));
+        }
+        g_ptr_array_free(self->jobs, TRUE);
+        mce_proxy_unref(self->proxy);
+        g_main_context_unref(self->context);
+        g_slice_free(MceScheduler, self);
+    }
+}
+
+guint
+mce_scheduler_add_job(
+    MceScheduler* self,
+    int priority,
+    guint deadline_ms,
+    MceSchedulerJobFunc run,
+    MceSchedulerJobFunc preempt,
+    void* arg,
+    GDestroyNotify destroy)
+{
+    if (G_LIKELY(self) && G_LIKELY(run)) {
+        MceSchedulerJob* job = g_slice_new0(MceSchedulerJob);
+        guint i;
+
+        job->id = ++self->last_id;
+        if (!job->id) {
+            job->id = ++self->last_id;
+        }
+        job->priority = priority;
+        if (deadline_ms) {
+            job->deadline = mce_clock_boottime() +
+                ((gint64)deadline_ms) * 1000;
+        }
+        job->run = run;
+        job->preempt = preempt;
+        job->arg = arg;
+        job->destroy = destroy;
+
+        /* Insert after the jobs of the same or higher priority */
+        for (i = 0; i < self->jobs->len; i++) {
+            const MceSchedulerJob* other = self->jobs->pdata[i];
+
+            if (other->priority < priority) {
+                break;
+            }
+        }
+        g_ptr_array_add(self->jobs, job);
+        if (i + 1 < self->jobs->len) {
+            gpointer* pos = self->jobs->pdata + i;
+
+            memmove(pos + 1, pos, sizeof(pos[0]) * (self->jobs->len - i - 1));
+            *pos = job;
+        }
+
+        /* Start it (or arm the deadline timer) on the next iteration */
+        mce_scheduler_schedule(self);
+        return job->id;
+    }
+    return 0;
+}
+
+gboolean
+mce_scheduler_cancel_job(
+    MceScheduler* self,
+    guint id)
+{
+    return G_LIKELY(self) && G_LIKELY(id) &&
+        mce_scheduler_remove_job(self, id);
+}
+
+void
+mce_scheduler_job_done(
+    MceScheduler* self,
+    guint id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        mce_scheduler_remove_job(self, id);
+    }
+}
+
+gboolean
+mce_scheduler_conditions_met(
+    MceScheduler* self)
+{
+    return G_LIKELY(self) && mce_scheduler_check(self);
+}
+
+void
+mce_scheduler_set_battery_level(
+    MceScheduler* self,
+    guint level)
+{
+    if (G_LIKELY(self)) {
+        self->battery_level = level;
+        if (level < MCE_SCHEDULER_BATTERY_NEVER) {
+            /* Battery is only tracked if it matters */
+            if (!self->battery) {
+                self->battery = mce_battery_new_for_proxy(self->proxy);
+                self->battery_id[0] =
+                    mce_battery_add_valid_changed_handler_in_context(
+                        self->battery, mce_scheduler_battery_changed, self);
+                self->battery_id[1] =
+                    mce_battery_add_level_changed_handler_in_context(
+                        self->battery, mce_scheduler_battery_changed, self);
+            }
+        } else if (self->battery) {
+            mce_battery_remove_all_handlers(self->battery, self->battery_id);
+            mce_battery_unref(self->battery);
+            self->battery = NULL;
+        }
+        mce_scheduler_changed(self);
+    }
+}
+
+void
+mce_scheduler_set_batch_window(
+    MceScheduler* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        self->batch_window = ((gint64)ms) * 1000;
+        mce_scheduler_schedule(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
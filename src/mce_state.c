@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_state.h"
+#include "mce_proxy_p.h"
+#include "mce_log_p.h"
+
+/* Everything is protected by the proxy lock */
+struct mce_state_priv {
+    MceProxy* proxy;
+    GSource* notify;
+    guint coalesce_ms;
+    MCE_STATE_FIELDS changed;   /* Not yet reported */
+    guint pending_updates;
+    guint suppressed;
+    MceBattery* battery;
+    MceCharger* charger;
+    MceDisplay* display;
+    MceTklock* tklock;
+    MceInactivity* inactivity;
+    gulong battery_id[3];
+    gulong charger_id[2];
+    gulong display_id[2];
+    gulong tklock_id[3];
+    gulong inactivity_id[2];
+};
+
+enum mce_state_signal {
+    SIGNAL_CHANGED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_CHANGED_NAME     "mce-state-changed"
+
+static guint mce_state_signals[SIGNAL_COUNT] = { 0 };
+
+typedef GObjectClass MceStateClass;
+G_DEFINE_TYPE(MceState, mce_state, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_state_parent_class
+#define MCE_STATE_TYPE (mce_state_get_type())
+#define MCE_STATE(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_STATE_TYPE,MceState))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+gboolean
+mce_state_notify(
+    gpointer data)
+{
+    MceState* self = MCE_STATE(data);
+    MceStatePriv* priv = self->priv;
+    MceProxy* proxy = priv->proxy;
+    MCE_STATE_FIELDS changed;
+
+    mce_proxy_lock(proxy);
+    changed = priv->changed;
+    g_source_unref(priv->notify);
+    priv->notify = NULL;
+    priv->changed = MCE_STATE_NONE;
+    priv->suppressed += priv->pending_updates - 1;
+    priv->pending_updates = 0;
+    g_signal_emit(self, mce_state_signals[SIGNAL_CHANGED], 0, changed);
+    mce_proxy_unlock(proxy);
+    return G_SOURCE_REMOVE;
+}
+
+#define MCE_STATE_SET(field,value,bit) do { \
+        if (snapshot->field != (value)) { \
+            snapshot->field = (value); \
+            changed |= (bit); \
+        } \
+    } while (0)
+
+static
+void
+mce_state_update(
+    MceState* self)
+{
+    MceStatePriv* priv = self->priv;
+    MceSnapshot* snapshot = &self->snapshot;
+    MCE_STATE_FIELDS changed = MCE_STATE_NONE;
+
+    MCE_STATE_SET(battery_valid, priv->battery->valid,
+        MCE_STATE_BATTERY_VALID);
+    MCE_STATE_SET(battery_level, priv->battery->level,
+        MCE_STATE_BATTERY_LEVEL);
+    MCE_STATE_SET(battery_status, priv->battery->status,
+        MCE_STATE_BATTERY_STATUS);
+    MCE_STATE_SET(charger_valid, priv->charger->valid,
+        MCE_STATE_CHARGER_VALID);
+    MCE_STATE_SET(charger_state, priv->charger->state,
+        MCE_STATE_CHARGER_STATE);
+    MCE_STATE_SET(display_valid, priv->display->valid,
+        MCE_STATE_DISPLAY_VALID);
+    MCE_STATE_SET(display_state, priv->display->state,
+        MCE_STATE_DISPLAY_STATE);
+    MCE_STATE_SET(tklock_valid, priv->tklock->valid,
+        MCE_STATE_TKLOCK_VALID);
+    MCE_STATE_SET(tklock_mode, priv->tklock->mode,
+        MCE_STATE_TKLOCK_MODE);
+    MCE_STATE_SET(tklock_locked, priv->tklock->locked,
+        MCE_STATE_TKLOCK_LOCKED);
+    MCE_STATE_SET(inactivity_valid, priv->inactivity->valid,
+        MCE_STATE_INACTIVITY_VALID);
+    MCE_STATE_SET(inactivity_status, priv->inactivity->status,
+        MCE_STATE_INACTIVITY_STATUS);
+
+    if (changed) {
+        snapshot->updates++;
+        priv->changed |= changed;
+        priv->pending_updates++;
+        if (!priv->notify) {
+            /*
+             * Idle priority lets the rest of the burst (e.g. the other
+             * replies to the initial queries) get processed first.
+             * The coalescing window, if any, merges the bursts too.
+             */
+            priv->notify = priv->coalesce_ms ?
+                g_timeout_source_new(priv->coalesce_ms) :
+                g_idle_source_new();
+            g_source_set_callback(priv->notify, mce_state_notify,
+                mce_state_ref(self), g_object_unref);
+            g_source_attach(priv->notify, mce_proxy_context(priv->proxy));
+        }
+    }
+}
+
+#undef MCE_STATE_SET
+
+static
+void
+mce_state_battery_changed(
+    MceBattery* battery,
+    void* arg)
+{
+    mce_state_update(MCE_STATE(arg));
+}
+
+static
+void
+mce_state_charger_changed(
+    MceCharger* charger,
+    void* arg)
+{
+    mce_state_update(MCE_STATE(arg));
+}
+
+static
+void
+mce_state_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    mce_state_update(MCE_STATE(arg));
+}
+
+static
+void
+mce_state_tklock_changed(
+    MceTklock* tklock,
+    void* arg)
+{
+    mce_state_update(MCE_STATE(arg));
+}
+
+static
+void
+mce_state_inactivity_changed(
+    MceInactivity* inactivity,
+    void* arg)
+{
+    mce_state_update(MCE_STATE(arg));
+}
+
+static
+void
+mce_state_start(
+    MceState* self)
+{
+    MceStatePriv* priv = self->priv;
+
+    priv->battery_id[0] = mce_battery_add_valid_changed_handler(
+        priv->battery, mce_state_battery_changed, self);
+    priv->battery_id[1] = mce_battery_add_level_changed_handler(
+        priv->battery, mce_state_battery_changed, self);
+    priv->battery_id[2] = mce_battery_add_status_changed_handler(
+        priv->battery, mce_state_battery_changed, self);
+    priv->charger_id[0] = mce_charger_add_valid_changed_handler(
+        priv->charger, mce_state_charger_changed, self);
+    priv->charger_id[1] = mce_charger_add_state_changed_handler(
+        priv->charger, mce_state_charger_changed, self);
+    priv->display_id[0] = mce_display_add_valid_changed_handler(
+        priv->display, mce_state_display_changed, self);
+    priv->display_id[1] = mce_display_add_state_changed_handler(
+        priv->display, mce_state_display_changed, self);
+    priv->tklock_id[0] = mce_tklock_add_valid_changed_handler(
+        priv->tklock, mce_state_tklock_changed, self);
+    priv->tklock_id[1] = mce_tklock_add_mode_changed_handler(
+        priv->tklock, mce_state_tklock_changed, self);
+    priv->tklock_id[2] = mce_tklock_add_locked_changed_handler(
+        priv->tklock, mce_state_tklock_changed, self);
+    priv->inactivity_id[0] = mce_inactivity_add_valid_changed_handler(
+        priv->inactivity, mce_state_inactivity_changed, self);
+    priv->inactivity_id[1] = mce_inactivity_add_status_changed_handler(
+        priv->inactivity, mce_state_inactivity_changed, self);
+}
+
+static
+void
+mce_state_stop(
+    MceState* self)
+{
+    MceStatePriv* priv = self->priv;
+
+    mce_battery_remove_all_handlers(priv->battery, priv->battery_id);
+    mce_charger_remove_all_handlers(priv->charger, priv->charger_id);
+    mce_display_remove_all_handlers(priv->display, priv->display_id);
+    mce_tklock_remove_all_handlers(priv->tklock, priv->tklock_id);
+    mce_inactivity_remove_all_handlers(priv->inactivity,
+        priv->inactivity_id);
+}
+
+static
+void
+mce_state_update_demand(
+    MceState* self)
+{
+    MceStatePriv* priv = self->priv;
+
+    if (g_signal_has_handler_pending(self,
+        mce_state_signals[SIGNAL_CHANGED], 0, TRUE)) {
+        if (!priv->battery_id[0]) {
+            /* The first handler has been connected, start tracking */
+            mce_state_start(self);
+            mce_state_update(self);
+        }
+    } else if (priv->battery_id[0]) {
+        /* Nobody is listening, stop tracking (objects become invalid) */
+        mce_state_stop(self);
+        mce_state_update(self);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceState*
+mce_state_new()
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceState* self = mce_state_new_for_proxy(proxy);
+
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceState*
+mce_state_new_for_proxy(
+    MceProxy* proxy)
+{
+    MceState* self = NULL;
+
+    if (G_LIKELY(proxy)) {
+        mce_proxy_lock(proxy);
+        self = mce_proxy_object_ref(proxy, MCE_PROXY_OBJECT_STATE);
+        if (!self) {
+            MceStatePriv* priv;
+
+            self = g_object_new(MCE_STATE_TYPE, NULL);
+            priv = self->priv;
+            priv->proxy = mce_proxy_ref(proxy);
+            priv->battery = mce_battery_new_for_proxy(proxy);
+            priv->charger = mce_charger_new_for_proxy(proxy);
+            priv->display = mce_display_new_for_proxy(proxy);
+            priv->tklock = mce_tklock_new_for_proxy(proxy);
+            priv->inactivity = mce_inactivity_new_for_proxy(proxy);
+            mce_proxy_object_set(proxy, MCE_PROXY_OBJECT_STATE, self);
+        }
+        mce_proxy_unlock(proxy);
+    }
+    return self;
+}
+
+MceState*
+mce_state_ref(
+    MceState* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_STATE(self));
+    }
+    return self;
+}
+
+void
+mce_state_unref(
+    MceState* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_unref(MCE_STATE(self));
+    }
+}
+
+gulong
+mce_state_add_changed_handler(
+    MceState* self,
+    MceStateFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = g_signal_connect(self, SIGNAL_CHANGED_NAME, G_CALLBACK(fn), arg);
+        mce_state_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
+    }
+    return 0;
+}
+
+void
+mce_state_remove_handler(
+    MceState* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        g_signal_handler_disconnect(self, id);
+        mce_state_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_state_set_coalesce_window(
+    MceState* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        /* Takes effect with the next notification */
+        mce_proxy_lock(proxy);
+        self->priv->coalesce_ms = ms;
+        mce_proxy_unlock(proxy);
+    }
+}
+
+guint
+mce_state_get_suppressed_count(
+    MceState* self)
+{
+    guint count = 0;
+
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        count = self->priv->suppressed;
+        mce_proxy_unlock(proxy);
+    }
+    return count;
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_state_init(
+    MceState* self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_STATE_TYPE,
+        MceStatePriv);
+}
+
+static
+void
+mce_state_finalize(
+    GObject* object)
+{
+    MceState* self = MCE_STATE(object);
+    MceStatePriv* priv = self->priv;
+
+    if (priv->battery_id[0]) {
+        mce_state_stop(self);
+    }
+    if (priv->notify) {
+        g_source_destroy(priv->notify);
+        g_source_unref(priv->notify);
+    }
+    mce_battery_unref(priv->battery);
+    mce_charger_unref(priv->charger);
+    mce_display_unref(priv->display);
+    mce_tklock_unref(priv->tklock);
+    mce_inactivity_unref(priv->inactivity);
+    mce_proxy_unref(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_state_class_init(
+    MceStateClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_state_finalize;
+    g_type_class_add_private(klass, sizeof(MceStatePriv));
+    mce_state_signals[SIGNAL_CHANGED] =
+        g_signal_new(SIGNAL_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+            0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
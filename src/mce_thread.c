@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_thread.h"
+#include "mce_proxy.h"
+#include "mce_log_p.h"
+
+#define MCE_SNAPSHOT_WORDS (sizeof(MceSnapshot)/sizeof(gint))
+G_STATIC_ASSERT(sizeof(MceSnapshot) == MCE_SNAPSHOT_WORDS * sizeof(gint));
+
+/*
+ * The snapshot is protected by a sequence lock. The worker thread is
+ * the only writer. Everything (including the snapshot itself) is
+ * accessed with atomic operations, one word at a time. The readers
+ * retry if the sequence number was odd or has changed while they
+ * were copying the words.
+ *
+ * The snapshot is copied from MceState once per main loop iteration
+ * of the worker thread, with all the changes made in that iteration.
+ */
+struct mce_thread_priv {
+    GThread* thread;
+    GMainContext* context;
+    GMainLoop* loop;
+    gint seq;
+    gint snapshot[MCE_SNAPSHOT_WORDS];
+};
+
+typedef GObjectClass MceThreadClass;
+G_DEFINE_TYPE(MceThread, mce_thread, G_TYPE_OBJECT)
+#define PARENT_CLASS mce_thread_parent_class
+#define MCE_THREAD_TYPE (mce_thread_get_type())
+#define MCE_THREAD(obj) (G_TYPE_CHECK_INSTANCE_CAST(obj,\
+        MCE_THREAD_TYPE,MceThread))
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_thread_publish(
+    MceState* state,
+    MCE_STATE_FIELDS changed,
+    void* arg)
+{
+    MceThreadPriv* priv = arg;
+    const gint* words = (const gint*)&state->snapshot;
+    guint i;
+
+    g_atomic_int_inc(&priv->seq);   /* Odd - being written */
+    for (i = 0; i < MCE_SNAPSHOT_WORDS; i++) {
+        g_atomic_int_set(priv->snapshot + i, words[i]);
+    }
+    g_atomic_int_inc(&priv->seq);   /* Even - consistent again */
+}
+
+static
+gpointer
+mce_thread_proc(
+    gpointer data)
+{
+    MceThreadPriv* priv = data;
+    GError* error = NULL;
+    GDBusConnection* bus;
+
+    /* All D-Bus callbacks will be invoked in our own context */
+    g_main_context_push_thread_default(priv->context);
+    bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (bus) {
+        MceProxy* proxy = mce_proxy_new_for_connection(bus, NULL, NULL,
+            NULL);
+        MceState* state = mce_state_new_for_proxy(proxy);
+        const gulong id = mce_state_add_changed_handler(state,
+            mce_thread_publish, priv);
+
+        g_object_unref(bus);
+        mce_proxy_unref(proxy);
+        g_main_loop_run(priv->loop);
+        mce_state_remove_handler(state, id);
+        mce_state_unref(state);
+    } else {
+        GERR("Failed to attach to system bus: %s", GERRMSG(error));
+        g_error_free(error);
+    }
+
+    /* Let the cancelled calls complete */
+    while (g_main_context_iteration(priv->context, FALSE));
+    g_main_context_pop_thread_default(priv->context);
+    return NULL;
+}
+
+static
+gboolean
+mce_thread_quit(
+    gpointer data)
+{
+    MceThreadPriv* priv = data;
+
+    g_main_loop_quit(priv->loop);
+    return G_SOURCE_REMOVE;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+MceThread*
+mce_thread_new()
+{
+    MceThread* self = g_object_new(MCE_THREAD_TYPE, NULL);
+    MceThreadPriv* priv = self->priv;
+
+    priv->context = g_main_context_new();
+    priv->loop = g_main_loop_new(priv->context, FALSE);
+    priv->thread = g_thread_new("mce", mce_thread_proc, priv);
+    return self;
+}
+
+MceThread*
+mce_thread_ref(
+    MceThread* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_ref(MCE_THREAD(self));
+    }
+    return self;
+}
+
+void
+mce_thread_unref(
+    MceThread* self)
+{
+    if (G_LIKELY(self)) {
+        g_object_unref(MCE_THREAD(self));
+    }
+}
+
+void
+mce_thread_get_snapshot(
+    MceThread* self,
+    MceSnapshot* snapshot)
+{
+    if (G_LIKELY(snapshot)) {
+        if (G_LIKELY(self)) {
+            MceThreadPriv* priv = self->priv;
+            gint* words = (gint*)snapshot;
+            gint seq;
+            guint i;
+
+            do {
+                seq = g_atomic_int_get(&priv->seq);
+                for (i = 0; i < MCE_SNAPSHOT_WORDS; i++) {
+                    words[i] = g_atomic_int_get(priv->snapshot + i);
+                }
+            } while ((seq & 1) || seq != g_atomic_int_get(&priv->seq));
+        } else {
+            memset(snapshot, 0, sizeof(*snapshot));
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+mce_thread_init(
+    MceThread* self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE(self, MCE_THREAD_TYPE,
+        MceThreadPriv);
+}
+
+static
+void
+mce_thread_finalize(
+    GObject* object)
+{
+    MceThread* self = MCE_THREAD(object);
+    MceThreadPriv* priv = self->priv;
+    GSource* quit = g_idle_source_new();
+
+    /*
+     * g_main_loop_quit() is not called directly because the loop
+     * may not be running yet. The idle source is only dispatched
+     * from inside the loop.
+     */
+    g_source_set_callback(quit, mce_thread_quit, priv, NULL);
+    g_source_attach(quit, priv->context);
+    g_source_unref(quit);
+    g_thread_join(priv->thread);
+    g_main_loop_unref(priv->loop);
+    g_main_context_unref(priv->context);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+mce_thread_class_init(
+    MceThreadClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = mce_thread_finalize;
+    g_type_class_add_private(klass, sizeof(MceThreadPriv));
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
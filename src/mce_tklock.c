@@ -35,7 +35,12 @@
  */
 
 #include "mce_tklock.h"
-#include "mce_proxy.h"
+#include "mce_callbacks_p.h"
+#include "mce_clock_p.h"
+#include "mce_context_p.h"
+#include "mce_history_p.h"
+#include "mce_proxy_p.h"
+#include "mce_wait_p.h"
 #include "mce_log_p.h"
 
 #include <mce/dbus-names.h>
@@ -43,14 +48,22 @@
 
 #include <gutil_misc.h>
 
-/* Generated headers */
-#include "com.nokia.mce.request.h"
-#include "com.nokia.mce.signal.h"
-
 struct mce_tklock_priv {
     MceProxy* proxy;
+    MceCallbacks callbacks;
+    guint seq;              /* Last MceStamp sequence number */
+    MceHistory* history;
+    gboolean eager;         /* Always tracked, see mce_tklock_new() */
+    guint pins;             /* Tracked regardless of the handlers */
     gulong proxy_valid_id;
     gulong tklock_mode_ind_id;
+    gboolean have_mode;
+    guint coalesce_ms;
+    GSource* coalesce_timer;
+    MCE_TKLOCK_MODE pending_mode;
+    gboolean pending_locked;
+    guint pending_transitions;
+    guint suppressed;
 };
 
 enum mce_tklock_signal {
@@ -60,12 +73,23 @@ enum mce_tklock_signal {
     SIGNAL_COUNT
 };
 
+/* Not a signal, only used with the callbacks */
+#define EVENT_MODE_TRANSITION SIGNAL_COUNT
+
 #define SIGNAL_VALID_CHANGED_NAME  "mce-tklock-valid-changed"
 #define SIGNAL_MODE_CHANGED_NAME   "mce-tklock-mode-changed"
 #define SIGNAL_LOCKED_CHANGED_NAME "mce-tklock-locked-changed"
 
 static guint mce_tklock_signals[SIGNAL_COUNT] = { 0 };
 
+static const MCE_HISTORY_FIELD mce_tklock_history_fields[] = {
+    MCE_HISTORY_TKLOCK_VALID,
+    MCE_HISTORY_TKLOCK_MODE,
+    MCE_HISTORY_TKLOCK_LOCKED
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mce_tklock_history_fields) == SIGNAL_COUNT);
+
 typedef GObjectClass MceTklockClass;
 G_DEFINE_TYPE(MceTklock, mce_tklock, G_TYPE_OBJECT)
 #define PARENT_CLASS mce_tklock_parent_class
@@ -79,13 +103,135 @@ G_DEFINE_TYPE(MceTklock, mce_tklock, G_TYPE_OBJECT)
 
 static
 void
-mce_tklock_mode_update(
+mce_tklock_emit(
     MceTklock* self,
-    const char* mode)
+    enum mce_tklock_signal sig)
 {
     MceTklockPriv* priv = self->priv;
+
+    if (priv->history) {
+        /* Both mode and locked come from the same report */
+        const MceStamp* stamp = &self->mode_stamp;
+        gint value = 0;
+
+        switch (sig) {
+        case SIGNAL_VALID_CHANGED:
+            value = self->valid;
+            /* Becoming valid is caused by a report, invalid is not */
+            if (!self->valid) {
+                stamp = NULL;
+            }
+            break;
+        case SIGNAL_MODE_CHANGED:
+            value = self->mode;
+            break;
+        case SIGNAL_LOCKED_CHANGED:
+            value = self->locked;
+            break;
+        case SIGNAL_COUNT:
+            break;
+        }
+        mce_history_add(priv->history, mce_tklock_history_fields[sig], value,
+            stamp, priv->seq);
+    }
+    g_signal_emit(self, mce_tklock_signals[sig], 0);
+    mce_callbacks_emit(&priv->callbacks, sig, self);
+}
+
+static
+gboolean
+mce_tklock_has_handlers(
+    MceTklock* self,
+    enum mce_tklock_signal sig)
+{
+    const MceCallbacks* callbacks = &self->priv->callbacks;
+
+    /* Transition callbacks need the mode to be tracked */
+    return (sig == SIGNAL_MODE_CHANGED &&
+        mce_callbacks_has(callbacks, EVENT_MODE_TRANSITION)) ||
+        mce_callbacks_has(callbacks, sig) ||
+        g_signal_has_handler_pending(self, mce_tklock_signals[sig], 0,
+            TRUE);
+}
+
+static
+void
+mce_tklock_mode_set(
+    MceTklock* self,
+    MCE_TKLOCK_MODE mode,
+    gboolean locked)
+{
     const MCE_TKLOCK_MODE prev_mode = self->mode;
     const gboolean prev_locked = self->locked;
+
+    self->mode = mode;
+    self->locked = locked;
+    if (self->mode != prev_mode) {
+        mce_tklock_emit(self, SIGNAL_MODE_CHANGED);
+    }
+    if (self->locked != prev_locked) {
+        mce_tklock_emit(self, SIGNAL_LOCKED_CHANGED);
+    }
+}
+
+static
+void
+mce_tklock_coalesce_cancel(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = self->priv;
+
+    if (priv->coalesce_timer) {
+        g_source_destroy(priv->coalesce_timer);
+        g_source_unref(priv->coalesce_timer);
+        priv->coalesce_timer = NULL;
+    }
+    priv->pending_transitions = 0;
+}
+
+static
+void
+mce_tklock_coalesce_flush(
+    MceTklock* self)
+{
+    MceTklockPriv* priv = self->priv;
+    const guint transitions = priv->pending_transitions;
+
+    mce_tklock_coalesce_cancel(self);
+    if (transitions) {
+        /* Everything but the last change gets swallowed */
+        const gboolean changed = (self->mode != priv->pending_mode);
+
+        priv->suppressed += transitions - (changed ? 1 : 0);
+        mce_tklock_mode_set(self, priv->pending_mode, priv->pending_locked);
+    }
+}
+
+static
+gboolean
+mce_tklock_coalesce_timeout(
+    gpointer data)
+{
+    MceTklock* self = MCE_TKLOCK(data);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    g_source_unref(self->priv->coalesce_timer);
+    self->priv->coalesce_timer = NULL;
+    mce_tklock_coalesce_flush(self);
+    mce_proxy_unlock(proxy);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_tklock_mode_update(
+    MceTklock* self,
+    const char* mode)
+{
+    MceTklockPriv* priv = self->priv;
+    MCE_TKLOCK_MODE new_mode = self->mode;
+    gboolean new_locked = self->locked;
     static const struct mce_tklock_mode_desc {
         const char* name;
         MCE_TKLOCK_MODE mode;
@@ -104,88 +250,142 @@ mce_tklock_mode_update(
 
     for (i=0; i<G_N_ELEMENTS(mce_tklock_modes); i++) {
         if (!g_strcmp0(mode, mce_tklock_modes[i].name)) {
-            self->mode = mce_tklock_modes[i].mode;
-            self->locked = mce_tklock_modes[i].locked;
+            new_mode = mce_tklock_modes[i].mode;
+            new_locked = mce_tklock_modes[i].locked;
             break;
         }
     }
     if (i == G_N_ELEMENTS(mce_tklock_modes)) {
         GWARN("Unexpected mode '%s'", mode);
     }
-    if (self->mode != prev_mode) {
-        g_signal_emit(self, mce_tklock_signals[SIGNAL_MODE_CHANGED], 0);
-    }
-    if (self->locked != prev_locked) {
-        g_signal_emit(self, mce_tklock_signals[SIGNAL_LOCKED_CHANGED], 0);
+    priv->have_mode = TRUE;
+    mce_residency_enter(mce_proxy_residency(priv->proxy,
+        MCE_PROXY_TKLOCK_MODE), new_mode, self->mode_stamp.time);
+    if (self->valid && priv->coalesce_ms) {
+        const MCE_TKLOCK_MODE last = priv->pending_transitions ?
+            priv->pending_mode : self->mode;
+
+        /* The mode gets reported when the window closes */
+        if (new_mode != last) {
+            mce_callbacks_emit_transition(&priv->callbacks,
+                EVENT_MODE_TRANSITION, self, last, new_mode);
+            priv->pending_mode = new_mode;
+            priv->pending_locked = new_locked;
+            priv->pending_transitions++;
+            if (!priv->coalesce_timer) {
+                priv->coalesce_timer = g_timeout_source_new(priv->coalesce_ms);
+                g_source_set_callback(priv->coalesce_timer,
+                    mce_tklock_coalesce_timeout, mce_tklock_ref(self),
+                    g_object_unref);
+                g_source_attach(priv->coalesce_timer,
+                    mce_proxy_context(priv->proxy));
+            }
+        }
+    } else {
+        if (self->valid && self->mode != new_mode) {
+            mce_callbacks_emit_transition(&priv->callbacks,
+                EVENT_MODE_TRANSITION, self, self->mode, new_mode);
+        }
+        mce_tklock_mode_set(self, new_mode, new_locked);
     }
     if (priv->proxy->valid && !self->valid) {
         self->valid = TRUE;
-        g_signal_emit(self, mce_tklock_signals[SIGNAL_VALID_CHANGED], 0);
+        mce_tklock_emit(self, SIGNAL_VALID_CHANGED);
     }
 }
 
 static
 void
-mce_tklock_mode_query_done(
-    GObject* proxy,
-    GAsyncResult* result,
-    gpointer arg)
+mce_tklock_mode_ind(
+    MceProxy* proxy,
+    const MceProxyValue* value,
+    void* arg)
 {
-    GError* error = NULL;
-    char* status = NULL;
     MceTklock* self = MCE_TKLOCK(arg);
 
-    if (com_nokia_mce_request_call_get_tklock_mode_finish(
-        COM_NOKIA_MCE_REQUEST(proxy), &status, result, &error)) {
-        GDEBUG("Mode is currently %s", status);
-        mce_tklock_mode_update(self, status);
-        g_free(status);
-    } else {
-        /*
-         * We could retry but it's probably not worth the trouble
-         * because the next time user locks/unlocks the screen we
-         * receive mce_tklock_mode_ind and sync our state with mce.
-         * Until then, this object stays invalid.
-         */
-        GWARN("Failed to query tklock mode %s", GERRMSG(error));
-        g_error_free(error);
-    }
-    mce_tklock_unref(self);
+    GDEBUG("Mode is %s", value->str);
+    self->mode_stamp.time = value->time;
+    self->mode_stamp.seq = ++self->priv->seq;
+    mce_tklock_mode_update(self, value->str);
 }
 
 static
 void
-mce_tklock_mode_ind(
-    ComNokiaMceSignal* proxy,
-    const char* mode,
-    gpointer arg)
+mce_tklock_update_demand(
+    MceTklock* self)
 {
-    GDEBUG("Mode is %s", mode);
-    mce_tklock_mode_update(MCE_TKLOCK(arg), mode);
+    MceTklockPriv* priv = self->priv;
+    gboolean demand = priv->eager || priv->pins;
+    int i;
+
+    for (i = 0; i < SIGNAL_COUNT && !demand; i++) {
+        demand = mce_tklock_has_handlers(self, i);
+    }
+    if (demand) {
+        if (!priv->tklock_mode_ind_id) {
+            /* The first handler has been connected, start tracking */
+            priv->tklock_mode_ind_id =
+                mce_proxy_add_signal_handler(priv->proxy,
+                    MCE_PROXY_TKLOCK_MODE, mce_tklock_mode_ind, self);
+        }
+    } else if (priv->tklock_mode_ind_id) {
+        /* Nobody is listening, stop tracking */
+        mce_proxy_remove_signal_handler(priv->proxy,
+            MCE_PROXY_TKLOCK_MODE, priv->tklock_mode_ind_id);
+        priv->tklock_mode_ind_id = 0;
+        priv->have_mode = FALSE;
+        mce_tklock_coalesce_cancel(self);
+        if (self->valid) {
+            self->valid = FALSE;
+            mce_tklock_emit(self, SIGNAL_VALID_CHANGED);
+        }
+    }
 }
 
 static
-void
-mce_tklock_mode_query(
-    MceTklock* self)
+gulong
+mce_tklock_add_handler(
+    MceTklock* self,
+    const char* name,
+    MceTklockFunc fn,
+    void* arg,
+    gboolean in_context)
 {
-    MceTklockPriv* priv = self->priv;
-    MceProxy* proxy = priv->proxy;
-
-    /*
-     * proxy->signal and proxy->request may not be available at the
-     * time when MceTklock is created. In that case we have to wait
-     * for the valid signal before we can connect the tklock mode
-     * signal and submit the initial query.
-     */
-    if (proxy->signal && !priv->tklock_mode_ind_id) {
-        priv->tklock_mode_ind_id = g_signal_connect(proxy->signal,
-            MCE_TKLOCK_MODE_SIG, G_CALLBACK(mce_tklock_mode_ind), self);
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = in_context ?
+            mce_context_connect(self, name, G_CALLBACK(fn), arg) :
+            g_signal_connect(self, name, G_CALLBACK(fn), arg);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
-    if (proxy->request && proxy->valid) {
-        com_nokia_mce_request_call_get_tklock_mode(proxy->request, NULL,
-            mce_tklock_mode_query_done, mce_tklock_ref(self));
+    return 0;
+}
+
+static
+gulong
+mce_tklock_add_callback(
+    MceTklock* self,
+    enum mce_tklock_signal sig,
+    MceTklockFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add(&self->priv->callbacks, sig, G_CALLBACK(fn),
+            arg);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
     }
+    return 0;
 }
 
 static
@@ -197,15 +397,83 @@ mce_tklock_valid_changed(
     MceTklock* self = MCE_TKLOCK(arg);
 
     if (proxy->valid) {
-        mce_tklock_mode_query(self);
+        if (self->priv->have_mode && !self->valid) {
+            /* The initial query has completed before the name appeared */
+            self->valid = TRUE;
+            mce_tklock_emit(self, SIGNAL_VALID_CHANGED);
+        }
     } else {
+        self->priv->have_mode = FALSE;
+        mce_residency_leave(mce_proxy_residency(self->priv->proxy,
+            MCE_PROXY_TKLOCK_MODE), mce_clock_boottime());
+        mce_tklock_coalesce_cancel(self);
         if (self->valid) {
             self->valid = FALSE;
-            g_signal_emit(self, mce_tklock_signals[SIGNAL_VALID_CHANGED], 0);
+            mce_tklock_emit(self, SIGNAL_VALID_CHANGED);
         }
     }
 }
 
+static
+void
+mce_tklock_pin(
+    gpointer object)
+{
+    MceTklock* self = MCE_TKLOCK(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    self->priv->pins++;
+    mce_tklock_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+void
+mce_tklock_unpin(
+    gpointer object)
+{
+    MceTklock* self = MCE_TKLOCK(object);
+    MceProxy* proxy = self->priv->proxy;
+
+    mce_proxy_lock(proxy);
+    GASSERT(self->priv->pins);
+    self->priv->pins--;
+    mce_tklock_update_demand(self);
+    mce_proxy_unlock(proxy);
+}
+
+static
+MceTklock*
+mce_tklock_create(
+    MceProxy* proxy,
+    gboolean eager)
+{
+    /* Eager and lazy objects don't share the state */
+    const MCE_PROXY_OBJECT type = eager ?
+        MCE_PROXY_OBJECT_TKLOCK_EAGER :
+        MCE_PROXY_OBJECT_TKLOCK;
+    MceTklock* self;
+
+    /* MCE assumes one tklock */
+    mce_proxy_lock(proxy);
+    self = mce_proxy_object_ref(proxy, type);
+    if (!self) {
+        MceTklockPriv* priv;
+
+        self = g_object_new(MCE_TKLOCK_TYPE, NULL);
+        priv = self->priv;
+        priv->proxy = mce_proxy_ref(proxy);
+        priv->eager = eager;
+        priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(proxy,
+            mce_tklock_valid_changed, self);
+        mce_tklock_update_demand(self);
+        mce_proxy_object_set(proxy, type, self);
+    }
+    mce_proxy_unlock(proxy);
+    return self;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -213,18 +481,30 @@ mce_tklock_valid_changed(
 MceTklock*
 mce_tklock_new()
 {
-    /* MCE assumes one tklock */
-    static MceTklock* mce_tklock_instance = NULL;
+    MceProxy* proxy = mce_proxy_new();
+    MceTklock* self = mce_tklock_create(proxy, TRUE);
 
-    if (mce_tklock_instance) {
-        mce_tklock_ref(mce_tklock_instance);
-    } else {
-        mce_tklock_instance = g_object_new(MCE_TKLOCK_TYPE, NULL);
-        mce_tklock_mode_query(mce_tklock_instance);
-        g_object_add_weak_pointer(G_OBJECT(mce_tklock_instance),
-            (gpointer*)(&mce_tklock_instance));
-    }
-    return mce_tklock_instance;
+    mce_proxy_unref(proxy);
+    return self;
+}
+
+MceTklock*
+mce_tklock_new_for_proxy(
+    MceProxy* proxy)
+{
+    return G_LIKELY(proxy) ? mce_tklock_create(proxy, FALSE) : NULL;
+}
+
+MceTklock*
+mce_tklock_new_sync(
+    guint timeout_ms)
+{
+    MceProxy* proxy = mce_proxy_new();
+    MceTklock* self = mce_tklock_create(proxy, TRUE);
+
+    mce_proxy_sync(proxy, timeout_ms);
+    mce_proxy_unref(proxy);
+    return self;
 }
 
 MceTklock*
@@ -252,8 +532,18 @@ mce_tklock_add_valid_changed_handler(
     MceTklockFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_VALID_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_tklock_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_tklock_add_valid_changed_handler_in_context(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_handler(self, SIGNAL_VALID_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -262,8 +552,18 @@ mce_tklock_add_mode_changed_handler(
     MceTklockFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_MODE_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_tklock_add_handler(self, SIGNAL_MODE_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_tklock_add_mode_changed_handler_in_context(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_handler(self, SIGNAL_MODE_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 gulong
@@ -272,8 +572,18 @@ mce_tklock_add_locked_changed_handler(
     MceTklockFunc fn,
     void* arg)
 {
-    return (G_LIKELY(self) && G_LIKELY(fn)) ? g_signal_connect(self,
-        SIGNAL_LOCKED_CHANGED_NAME, G_CALLBACK(fn), arg) : 0;
+    return mce_tklock_add_handler(self, SIGNAL_LOCKED_CHANGED_NAME,
+        fn, arg, FALSE);
+}
+
+gulong
+mce_tklock_add_locked_changed_handler_in_context(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_handler(self, SIGNAL_LOCKED_CHANGED_NAME,
+        fn, arg, TRUE);
 }
 
 void
@@ -282,7 +592,12 @@ mce_tklock_remove_handler(
     gulong id)
 {
     if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
         g_signal_handler_disconnect(self, id);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
     }
 }
 
@@ -292,7 +607,154 @@ mce_tklock_remove_handlers(
     gulong* ids,
     guint count)
 {
-    gutil_disconnect_handlers(self, ids, count);
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        gutil_disconnect_handlers(self, ids, count);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+gulong
+mce_tklock_add_valid_changed_callback(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_callback(self, SIGNAL_VALID_CHANGED, fn, arg);
+}
+
+gulong
+mce_tklock_add_mode_changed_callback(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_callback(self, SIGNAL_MODE_CHANGED, fn, arg);
+}
+
+gulong
+mce_tklock_add_mode_transition_callback(
+    MceTklock* self,
+    guint from_mask,
+    guint to_mask,
+    MceTklockTransitionFunc fn,
+    void* arg)
+{
+    if (G_LIKELY(self) && G_LIKELY(fn)) {
+        MceProxy* proxy = self->priv->proxy;
+        gulong id;
+
+        mce_proxy_lock(proxy);
+        id = mce_callbacks_add_transition(&self->priv->callbacks,
+            EVENT_MODE_TRANSITION, from_mask, to_mask, G_CALLBACK(fn), arg);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
+        return id;
+    }
+    return 0;
+}
+
+gulong
+mce_tklock_add_locked_changed_callback(
+    MceTklock* self,
+    MceTklockFunc fn,
+    void* arg)
+{
+    return mce_tklock_add_callback(self, SIGNAL_LOCKED_CHANGED, fn, arg);
+}
+
+void
+mce_tklock_remove_callback(
+    MceTklock* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        mce_callbacks_remove(&self->priv->callbacks, id);
+        mce_tklock_update_demand(self);
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_tklock_set_coalesce_window(
+    MceTklock* self,
+    guint ms)
+{
+    if (G_LIKELY(self)) {
+        MceTklockPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        priv->coalesce_ms = ms;
+        if (!ms) {
+            mce_tklock_coalesce_flush(self);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+guint
+mce_tklock_get_suppressed_count(
+    MceTklock* self)
+{
+    guint count = 0;
+
+    if (G_LIKELY(self)) {
+        MceProxy* proxy = self->priv->proxy;
+
+        mce_proxy_lock(proxy);
+        count = self->priv->suppressed;
+        mce_proxy_unlock(proxy);
+    }
+    return count;
+}
+
+void
+mce_tklock_set_history(
+    MceTklock* self,
+    MceHistory* history)
+{
+    if (G_LIKELY(self)) {
+        MceTklockPriv* priv = self->priv;
+        MceProxy* proxy = priv->proxy;
+
+        mce_proxy_lock(proxy);
+        if (priv->history != history) {
+            mce_history_unref(priv->history);
+            priv->history = mce_history_ref(history);
+        }
+        mce_proxy_unlock(proxy);
+    }
+}
+
+void
+mce_tklock_wait_valid_async(
+    MceTklock* self,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(self)) {
+        mce_wait_valid_async(self, SIGNAL_VALID_CHANGED_NAME, &self->valid,
+            mce_tklock_pin, mce_tklock_unpin, timeout_ms, cancellable,
+            callback, user_data);
+    }
+}
+
+gboolean
+mce_tklock_wait_valid_finish(
+    MceTklock* self,
+    GAsyncResult* result,
+    GError** error)
+{
+    return mce_wait_valid_finish(self, result, error);
 }
 
 /*==========================================================================*
@@ -310,25 +772,39 @@ mce_tklock_init(
     self->priv = priv;
     self->mode = MCE_TKLOCK_MODE_LOCKED;
     self->locked = TRUE;
-    priv->proxy = mce_proxy_new();
-    priv->proxy_valid_id = mce_proxy_add_valid_changed_handler(priv->proxy,
-        mce_tklock_valid_changed, self);
 }
 
 static
 void
-mce_tklock_finalize(
+mce_tklock_dispose(
     GObject* object)
 {
     MceTklock* self = MCE_TKLOCK(object);
     MceTklockPriv* priv = self->priv;
 
-    if (priv->tklock_mode_ind_id) {
-        g_signal_handler_disconnect(priv->proxy->signal,
-            priv->tklock_mode_ind_id);
-    }
+    /* Nothing may run on the proxy thread after this point */
+    mce_proxy_lock(priv->proxy);
+    mce_proxy_remove_signal_handler(priv->proxy, MCE_PROXY_TKLOCK_MODE,
+        priv->tklock_mode_ind_id);
+    priv->tklock_mode_ind_id = 0;
     mce_proxy_remove_handler(priv->proxy, priv->proxy_valid_id);
+    priv->proxy_valid_id = 0;
+    mce_proxy_unlock(priv->proxy);
+    G_OBJECT_CLASS(PARENT_CLASS)->dispose(object);
+}
+
+static
+void
+mce_tklock_finalize(
+    GObject* object)
+{
+    MceTklock* self = MCE_TKLOCK(object);
+    MceTklockPriv* priv = self->priv;
+
+    mce_tklock_coalesce_cancel(self);
     mce_proxy_unref(priv->proxy);
+    mce_callbacks_clear(&priv->callbacks);
+    mce_history_unref(priv->history);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -339,6 +815,7 @@ mce_tklock_class_init(
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
 
+    object_class->dispose = mce_tklock_dispose;
     object_class->finalize = mce_tklock_finalize;
     g_type_class_add_private(klass, sizeof(MceTklockPriv));
     mce_tklock_signals[SIGNAL_VALID_CHANGED] =
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2019-2022 Jolla Ltd.
+ * Copyright (C) 2019-2022 Slava Monich <slava.monich@jolla.com>
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "mce_wait.h"
+#include "mce_battery.h"
+#include "mce_charger.h"
+#include "mce_display.h"
+#include "mce_inactivity.h"
+#include "mce_tklock.h"
+#include "mce_proxy.h"
+#include "mce_wait_p.h"
+#include "mce_context_p.h"
+#include "mce_log_p.h"
+
+/* Lives in the thread-default context of the waiter */
+typedef struct mce_wait {
+    GTask* task;
+    const gboolean* valid;
+    gulong valid_id;
+    GSource* timeout;
+    GSource* cancel;
+} MceWait;
+
+/* Released together with the task, after the result has been delivered */
+typedef struct mce_wait_pin {
+    gpointer object;
+    MceWaitPinFunc unpin;
+} MceWaitPin;
+
+typedef struct mce_wait_barrier {
+    GTask* task;
+    GPtrArray* results;     /* Owned by the task, keeps the objects pinned */
+    guint pending;
+    GError* error;
+} MceWaitBarrier;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+mce_wait_complete(
+    MceWait* wait,
+    GError* error)
+{
+    GTask* task = wait->task;
+
+    g_signal_handler_disconnect(g_task_get_source_object(task),
+        wait->valid_id);
+    if (wait->timeout) {
+        g_source_destroy(wait->timeout);
+        g_source_unref(wait->timeout);
+    }
+    if (wait->cancel) {
+        g_source_destroy(wait->cancel);
+        g_source_unref(wait->cancel);
+    }
+    g_slice_free(MceWait, wait);
+    if (error) {
+        g_task_return_error(task, error);
+    } else {
+        g_task_return_boolean(task, TRUE);
+    }
+    g_object_unref(task);
+}
+
+static
+void
+mce_wait_pin_free(
+    gpointer data)
+{
+    MceWaitPin* pin = data;
+
+    pin->unpin(pin->object);
+    g_object_unref(pin->object);
+    g_slice_free(MceWaitPin, pin);
+}
+
+static
+void
+mce_wait_valid_changed(
+    GObject* object,
+    void* arg)
+{
+    MceWait* wait = arg;
+
+    if (*wait->valid) {
+        mce_wait_complete(wait, NULL);
+    }
+}
+
+static
+gboolean
+mce_wait_timeout(
+    gpointer data)
+{
+    mce_wait_complete(data, g_error_new_literal(G_IO_ERROR,
+        G_IO_ERROR_TIMED_OUT, "Timed out waiting for mce"));
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+mce_wait_cancelled(
+    GCancellable* cancellable,
+    gpointer data)
+{
+    GError* error = NULL;
+
+    g_cancellable_set_error_if_cancelled(cancellable, &error);
+    mce_wait_complete(data, error);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mce_wait_barrier_check(
+    MceWaitBarrier* barrier)
+{
+    if (!--barrier->pending) {
+        GTask* task = barrier->task;
+
+        if (barrier->error) {
+            g_task_return_error(task, barrier->error);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+        g_slice_free(MceWaitBarrier, barrier);
+        g_object_unref(task);
+    }
+}
+
+static
+void
+mce_wait_barrier_done(
+    GObject* object,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    MceWaitBarrier* barrier = user_data;
+    GError* error = NULL;
+
+    /* Keep the object pinned until the barrier's result is delivered */
+    g_ptr_array_add(barrier->results, g_object_ref(result));
+    if (!mce_wait_valid_finish(object, result, &error)) {
+        /* All waits share the timeout and cancellable, keep the first */
+        if (barrier->error) {
+            g_error_free(error);
+        } else {
+            barrier->error = error;
+        }
+    }
+    mce_wait_barrier_check(barrier);
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+void
+mce_wait_valid_async(
+    gpointer object,
+    const char* signal_name,
+    const gboolean* valid,
+    MceWaitPinFunc pin,
+    MceWaitPinFunc unpin,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    GTask* task = g_task_new(object, cancellable, callback, user_data);
+
+    if (!g_task_return_error_if_cancelled(task)) {
+        MceWait* wait = g_slice_new0(MceWait);
+        GMainContext* context = g_task_get_context(task);
+
+        MceWaitPin* pinned = g_slice_new(MceWaitPin);
+
+        /*
+         * The object stays pinned until the task is gone, i.e. until
+         * the callback has had a chance to connect its handlers.
+         */
+        pin(object);
+        pinned->object = g_object_ref(object);
+        pinned->unpin = unpin;
+        g_task_set_task_data(task, pinned, mce_wait_pin_free);
+
+        wait->task = task;
+        wait->valid = valid;
+
+        /* Connect first, so that nothing falls between the cracks */
+        wait->valid_id = mce_context_connect(object, signal_name,
+            G_CALLBACK(mce_wait_valid_changed), wait);
+        if (*valid) {
+            mce_wait_complete(wait, NULL);
+            return;
+        }
+        if (timeout_ms) {
+            wait->timeout = g_timeout_source_new(timeout_ms);
+            g_source_set_callback(wait->timeout, mce_wait_timeout,
+                wait, NULL);
+            g_source_attach(wait->timeout, context);
+        }
+        if (cancellable) {
+            wait->cancel = g_cancellable_source_new(cancellable);
+            g_source_set_callback(wait->cancel,
+                (GSourceFunc)mce_wait_cancelled, wait, NULL);
+            g_source_attach(wait->cancel, context);
+        }
+        return;
+    }
+    g_object_unref(task);
+}
+
+gboolean
+mce_wait_valid_finish(
+    gpointer object,
+    GAsyncResult* result,
+    GError** error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, object), FALSE);
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+mce_wait_ready_async(
+    MceProxy* proxy,
+    MCE_WAIT_OBJECTS objects,
+    guint timeout_ms,
+    GCancellable* cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+    MceWaitBarrier* barrier;
+
+    if (!proxy) {
+        /* There's no implicit shared proxy */
+        g_task_report_new_error(NULL, callback, user_data,
+            mce_wait_ready_async, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+            "No proxy");
+        return;
+    }
+
+    barrier = g_slice_new0(MceWaitBarrier);
+
+    /* The objects are kept alive by their tasks */
+    barrier->task = g_task_new(NULL, cancellable, callback, user_data);
+    barrier->results = g_ptr_array_new_with_free_func(g_object_unref);
+    g_task_set_task_data(barrier->task, barrier->results,
+        (GDestroyNotify)g_ptr_array_unref);
+    barrier->pending = 1;
+    if (objects & MCE_WAIT_BATTERY) {
+        MceBattery* battery = mce_battery_new_for_proxy(proxy);
+
+        barrier->pending++;
+        mce_battery_wait_valid_async(battery, timeout_ms, cancellable,
+            mce_wait_barrier_done, barrier);
+        mce_battery_unref(battery);
+    }
+    if (objects & MCE_WAIT_CHARGER) {
+        MceCharger* charger = mce_charger_new_for_proxy(proxy);
+
+        barrier->pending++;
+        mce_charger_wait_valid_async(charger, timeout_ms, cancellable,
+            mce_wait_barrier_done, barrier);
+        mce_charger_unref(charger);
+    }
+    if (objects & MCE_WAIT_DISPLAY) {
+        MceDisplay* display = mce_display_new_for_proxy(proxy);
+
+        barrier->pending++;
+        mce_display_wait_valid_async(display, timeout_ms, cancellable,
+            mce_wait_barrier_done, barrier);
+        mce_display_unref(display);
+    }
+    if (objects & MCE_WAIT_INACTIVITY) {
+        MceInactivity* inactivity = mce_inactivity_new_for_proxy(proxy);
+
+        barrier->pending++;
+        mce_inactivity_wait_valid_async(inactivity, timeout_ms,
+            cancellable, mce_wait_barrier_done, barrier);
+        mce_inactivity_unref(inactivity);
+    }
+    if (objects & MCE_WAIT_TKLOCK) {
+        MceTklock* tklock = mce_tklock_new_for_proxy(proxy);
+
+        barrier->pending++;
+        mce_tklock_wait_valid_async(tklock, timeout_ms, cancellable,
+            mce_wait_barrier_done, barrier);
+        mce_tklock_unref(tklock);
+    }
+    mce_wait_barrier_check(barrier);
+}
+
+gboolean
+mce_wait_ready_finish(
+    GAsyncResult* result,
+    GError** error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, NULL), FALSE);
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
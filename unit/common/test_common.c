@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+#include "mce_clock_p.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+static
+gboolean
+test_timeout(
+    gpointer data)
+{
+    *((gboolean*)data) = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+test_inject(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    MceProxyValue* value)
+{
+    value->time = mce_clock_boottime();
+    mce_proxy_inject(proxy, property, value);
+}
+
+void
+test_init(
+    int* argc,
+    char** argv)
+{
+    g_test_init(argc, &argv, NULL);
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+}
+
+void
+test_flush(
+    void)
+{
+    while (g_main_context_iteration(NULL, FALSE));
+}
+
+gboolean
+test_run_until(
+    const gboolean* done,
+    guint timeout_ms)
+{
+    gboolean timed_out = FALSE;
+    const guint id = g_timeout_add(timeout_ms, test_timeout, &timed_out);
+
+    while (!*done && !timed_out) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    if (!timed_out) {
+        g_source_remove(id);
+    }
+    return *done;
+}
+
+void
+test_inject_int(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    gint i)
+{
+    MceProxyValue value;
+
+    memset(&value, 0, sizeof(value));
+    value.i = i;
+    test_inject(proxy, property, &value);
+}
+
+void
+test_inject_str(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    const char* str)
+{
+    MceProxyValue value;
+
+    memset(&value, 0, sizeof(value));
+    value.str = str;
+    test_inject(proxy, property, &value);
+}
+
+void
+test_inject_bool(
+    MceProxy* proxy,
+    MCE_PROXY_PROPERTY property,
+    gboolean b)
+{
+    MceProxyValue value;
+
+    memset(&value, 0, sizeof(value));
+    value.b = b;
+    test_inject(proxy, property, &value);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
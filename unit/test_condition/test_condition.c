@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_battery.h"
+#include "mce_condition.h"
+
+typedef struct test_condition {
+    guint dispatched;
+} TestCondition;
+
+static
+gboolean
+test_condition_cb(
+    gpointer data)
+{
+    TestCondition* test = data;
+
+    test->dispatched++;
+    return G_SOURCE_CONTINUE;
+}
+
+static
+GSource*
+test_condition_new(
+    MceProxy* proxy,
+    const MceConditionTerm* terms,
+    guint count,
+    TestCondition* test)
+{
+    GSource* source = mce_condition_source_new(proxy, terms, count);
+
+    g_assert(source);
+    g_source_set_callback(source, test_condition_cb, test, NULL);
+    g_source_attach(source, NULL);
+    return source;
+}
+
+static
+void
+test_condition_free(
+    GSource* source)
+{
+    g_source_destroy(source);
+    g_source_unref(source);
+}
+
+static const MceConditionTerm test_level_ge_50[] = {
+    { MCE_CONDITION_BATTERY_LEVEL, MCE_CONDITION_GE, 50 }
+};
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+
+    g_assert(!mce_condition_source_new(NULL, test_level_ge_50, 1));
+    g_assert(!mce_condition_source_new(proxy, NULL, 1));
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * edge
+ *==========================================================================*/
+
+static
+void
+test_edge(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    TestCondition test = { 0 };
+    GSource* source = test_condition_new(proxy, test_level_ge_50,
+        G_N_ELEMENTS(test_level_ge_50), &test);
+
+    /* Not valid yet, i.e. false */
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,0);
+
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 40);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,0);
+
+    /* Becoming true fires once */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 60);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,1);
+
+    /* Staying true doesn't */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 70);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,1);
+
+    /* Several edges before dispatch result in a single dispatch */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 10);
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 90);
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 20);
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 80);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,2);
+
+    test_condition_free(source);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * stale
+ *==========================================================================*/
+
+static
+void
+test_stale(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    TestCondition test = { 0 };
+    GSource* source = test_condition_new(proxy, test_level_ge_50,
+        G_N_ELEMENTS(test_level_ge_50), &test);
+
+    /* True and false again before the source gets dispatched */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 60);
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 40);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,0);
+
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 50);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,1);
+
+    test_condition_free(source);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * invalid
+ *==========================================================================*/
+
+static
+void
+test_invalid(
+    void)
+{
+    static const MceConditionTerm terms[] = {
+        { MCE_CONDITION_BATTERY_LEVEL, MCE_CONDITION_GE, 50 },
+        { MCE_CONDITION_INACTIVITY_STATUS, MCE_CONDITION_EQ, TRUE }
+    };
+    MceProxy* proxy = mce_proxy_new_detached();
+    TestCondition test = { 0 };
+    GSource* source = test_condition_new(proxy, terms,
+        G_N_ELEMENTS(terms), &test);
+
+    /* The inactivity term is false until the status is known */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 60);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,0);
+
+    test_inject_bool(proxy, MCE_PROXY_INACTIVITY_STATUS, TRUE);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,1);
+
+    test_condition_free(source);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * level_only
+ *==========================================================================*/
+
+static
+void
+test_level_only(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    TestCondition test = { 0 };
+    GSource* source = test_condition_new(proxy, test_level_ge_50,
+        G_N_ELEMENTS(test_level_ge_50), &test);
+    MceBattery* battery = mce_battery_new_for_proxy(proxy);
+
+    /* The level alone makes the battery valid, status isn't needed */
+    test_inject_int(proxy, MCE_PROXY_BATTERY_LEVEL, 60);
+    g_assert(battery->valid);
+    test_flush();
+    g_assert_cmpuint(test.dispatched, == ,1);
+
+    mce_battery_unref(battery);
+    test_condition_free(source);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/condition/" name
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    test_init(&argc, argv);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("edge"), test_edge);
+    g_test_add_func(TEST_("stale"), test_stale);
+    g_test_add_func(TEST_("invalid"), test_invalid);
+    g_test_add_func(TEST_("level_only"), test_level_only);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
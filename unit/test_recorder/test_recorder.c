@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_display.h"
+#include "mce_recorder.h"
+
+#include <mce/mode-names.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+#include <unistd.h>
+
+typedef struct test_display {
+    guint changes;
+} TestDisplay;
+
+static
+void
+test_display_changed(
+    MceDisplay* display,
+    void* arg)
+{
+    ((TestDisplay*)arg)->changes++;
+}
+
+static
+char*
+test_tmp_file(
+    void)
+{
+    char* path = g_build_filename(g_get_tmp_dir(), "test_recorder_XXXXXX",
+        NULL);
+    const int fd = g_mkstemp(path);
+
+    g_assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+static
+void
+test_inject_display(
+    MceProxy* proxy,
+    gint64 time,
+    const char* str)
+{
+    MceProxyValue value;
+
+    memset(&value, 0, sizeof(value));
+    value.time = time;
+    value.str = str;
+    mce_proxy_inject(proxy, MCE_PROXY_DISPLAY_STATUS, &value);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    g_assert(!mce_recorder_new(NULL, NULL, NULL));
+    g_assert(!mce_replay_new(NULL, NULL));
+    mce_recorder_free(NULL);
+    mce_replay_free(NULL);
+}
+
+/*==========================================================================*
+ * busy
+ *==========================================================================*/
+
+static
+void
+test_busy(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    char* path = test_tmp_file();
+    char* path2 = test_tmp_file();
+    GError* error = NULL;
+    MceRecorder* recorder = mce_recorder_new(proxy, path, &error);
+
+    g_assert(recorder);
+    g_assert(!error);
+
+    /* Only one recorder per proxy */
+    g_assert(!mce_recorder_new(proxy, path2, &error));
+    g_assert(g_error_matches(error, G_IO_ERROR, G_IO_ERROR_BUSY));
+    g_clear_error(&error);
+
+    /* Once it's gone, another one can be created */
+    mce_recorder_free(recorder);
+    recorder = mce_recorder_new(proxy, path2, &error);
+    g_assert(recorder);
+    mce_recorder_free(recorder);
+
+    g_unlink(path);
+    g_unlink(path2);
+    g_free(path);
+    g_free(path2);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * roundtrip
+ *==========================================================================*/
+
+static
+void
+test_roundtrip(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    MceDisplay* display = mce_display_new_for_proxy(proxy);
+    char* path = test_tmp_file();
+    TestDisplay test = { 0 };
+    MceRecorder* recorder = mce_recorder_new(proxy, path, NULL);
+    MceReplay* replay;
+    MceDisplay* replayed;
+    gulong id;
+
+    /* Only the values which are being tracked get recorded */
+    g_assert(recorder);
+    test_inject_display(proxy, 1000, MCE_DISPLAY_OFF_STRING);
+    id = mce_display_add_state_changed_handler(display,
+        test_display_changed, &test);
+    test_inject_display(proxy, 2000, MCE_DISPLAY_ON_STRING);
+    test_inject_display(proxy, 3000, MCE_DISPLAY_DIM_STRING);
+    test_inject_display(proxy, 4000, MCE_DISPLAY_OFF_STRING);
+    g_assert_cmpuint(test.changes, == ,3);
+    mce_display_remove_handler(display, id);
+    mce_recorder_free(recorder);
+
+    replay = mce_replay_new(path, NULL);
+    g_assert(replay);
+    g_assert_cmpuint(mce_replay_count(replay), == ,3);
+    replayed = mce_display_new_for_proxy(mce_replay_proxy(replay));
+    test.changes = 0;
+    id = mce_display_add_state_changed_handler(replayed,
+        test_display_changed, &test);
+
+    /* Same values with the same timestamps */
+    g_assert(mce_replay_step(replay));
+    g_assert(replayed->valid);
+    g_assert_cmpint(replayed->state, == ,MCE_DISPLAY_STATE_ON);
+    g_assert_cmpint(replayed->state_stamp.time, == ,2000);
+    g_assert_cmpuint(mce_replay_run(replay), == ,2);
+    g_assert_cmpint(replayed->state, == ,MCE_DISPLAY_STATE_OFF);
+    g_assert_cmpint(replayed->state_stamp.time, == ,4000);
+    g_assert_cmpuint(test.changes, == ,3);
+    g_assert(!mce_replay_step(replay));
+
+    mce_display_remove_handler(replayed, id);
+    mce_display_unref(replayed);
+    mce_replay_free(replay);
+    mce_display_unref(display);
+    g_unlink(path);
+    g_free(path);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/recorder/" name
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    test_init(&argc, argv);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("busy"), test_busy);
+    g_test_add_func(TEST_("roundtrip"), test_roundtrip);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
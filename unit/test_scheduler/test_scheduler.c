@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * You may use this file under the terms of BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "test_common.h"
+
+#include "mce_scheduler.h"
+
+#include <mce/dbus-names.h>
+#include <mce/mode-names.h>
+
+typedef struct test_job {
+    guint started;
+    gboolean done;
+} TestJob;
+
+static
+gboolean
+test_job_run(
+    MceScheduler* scheduler,
+    guint id,
+    void* arg)
+{
+    TestJob* job = arg;
+
+    job->started++;
+    job->done = TRUE;
+    return TRUE;
+}
+
+static
+void
+test_conditions(
+    MceProxy* proxy,
+    gboolean favorable)
+{
+    test_inject_str(proxy, MCE_PROXY_CHARGER_STATE, favorable ?
+        MCE_CHARGER_STATE_ON : MCE_CHARGER_STATE_OFF);
+    test_inject_str(proxy, MCE_PROXY_DISPLAY_STATUS, favorable ?
+        MCE_DISPLAY_OFF_STRING : MCE_DISPLAY_ON_STRING);
+    test_inject_bool(proxy, MCE_PROXY_INACTIVITY_STATUS, favorable);
+    test_flush();
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    g_assert(!mce_scheduler_new(NULL));
+    mce_scheduler_free(NULL);
+}
+
+/*==========================================================================*
+ * conditions
+ *==========================================================================*/
+
+static
+void
+test_favorable(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    MceScheduler* scheduler = mce_scheduler_new(proxy);
+    TestJob job = { 0, FALSE };
+
+    test_conditions(proxy, FALSE);
+    g_assert(!mce_scheduler_conditions_met(scheduler));
+    g_assert(mce_scheduler_add_job(scheduler, 0, 0, test_job_run, NULL,
+        &job, NULL));
+    test_flush();
+    g_assert_cmpuint(job.started, == ,0);
+
+    /* The job starts as soon as the conditions become favorable */
+    test_conditions(proxy, TRUE);
+    g_assert(mce_scheduler_conditions_met(scheduler));
+    g_assert_cmpuint(job.started, == ,1);
+
+    mce_scheduler_free(scheduler);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * window
+ *==========================================================================*/
+
+static
+void
+test_window(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    MceScheduler* scheduler = mce_scheduler_new(proxy);
+    TestJob job = { 0, FALSE };
+    guint id;
+
+    /* The deadline is within the window but hasn't expired */
+    test_conditions(proxy, FALSE);
+    mce_scheduler_set_batch_window(scheduler, 10000);
+    id = mce_scheduler_add_job(scheduler, 0, 5000, test_job_run, NULL,
+        &job, NULL);
+    g_assert(id);
+    test_flush();
+    g_assert_cmpuint(job.started, == ,0);
+
+    /* Changing the window doesn't start it either */
+    mce_scheduler_set_batch_window(scheduler, 20000);
+    test_flush();
+    g_assert_cmpuint(job.started, == ,0);
+
+    g_assert(mce_scheduler_cancel_job(scheduler, id));
+    mce_scheduler_free(scheduler);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * deadline
+ *==========================================================================*/
+
+static
+void
+test_deadline(
+    void)
+{
+    MceProxy* proxy = mce_proxy_new_detached();
+    MceScheduler* scheduler = mce_scheduler_new(proxy);
+    TestJob first = { 0, FALSE };
+    TestJob batched = { 0, FALSE };
+    TestJob later = { 0, FALSE };
+    TestJob nodeadline = { 0, FALSE };
+
+    test_conditions(proxy, FALSE);
+    mce_scheduler_set_batch_window(scheduler, 2000);
+    g_assert(mce_scheduler_add_job(scheduler, 0, 100, test_job_run, NULL,
+        &first, NULL));
+    g_assert(mce_scheduler_add_job(scheduler, 0, 1000, test_job_run, NULL,
+        &batched, NULL));
+    g_assert(mce_scheduler_add_job(scheduler, 0, 60000, test_job_run, NULL,
+        &later, NULL));
+    g_assert(mce_scheduler_add_job(scheduler, 0, 0, test_job_run, NULL,
+        &nodeadline, NULL));
+    test_flush();
+    g_assert_cmpuint(first.started, == ,0);
+    g_assert_cmpuint(batched.started, == ,0);
+
+    /* The expired deadline brings the jobs within the window along */
+    g_assert(test_run_until(&first.done, TEST_TIMEOUT_MS));
+    g_assert_cmpuint(first.started, == ,1);
+    g_assert_cmpuint(batched.started, == ,1);
+    g_assert_cmpuint(later.started, == ,0);
+    g_assert_cmpuint(nodeadline.started, == ,0);
+
+    mce_scheduler_free(scheduler);
+    mce_proxy_unref(proxy);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_(name) "/scheduler/" name
+
+int
+main(
+    int argc,
+    char* argv[])
+{
+    test_init(&argc, argv);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("favorable"), test_favorable);
+    g_test_add_func(TEST_("window"), test_window);
+    g_test_add_func(TEST_("deadline"), test_deadline);
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */